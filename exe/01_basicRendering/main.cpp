@@ -1,6 +1,12 @@
 #include <glbinding/gl/gl.h>
+#include <imgui.h>
 #include "orvis/Cubemap.hpp"
+#include "orvis/DynamicResolution.hpp"
+#include "orvis/GlProfiler.hpp"
+#include "orvis/HdrRenderTarget.hpp"
 #include "orvis/Scene.hpp"
+#include "orvis/UploadService.hpp"
+#include "orvis/VisibilityBuffer.hpp"
 using namespace gl;
 
 #include "orvis/Window.hpp"
@@ -17,18 +23,21 @@ int main()
 
     util::enableDebugCallback();
 
+    // streamed texture levels are uploaded on a worker thread with a shared context
+    UploadService uploadService(window);
+
     auto cam = std::make_shared<Camera>(glm::infinitePerspective(glm::radians(60.f), static_cast<float>(width) / static_cast<float>(height), 0.1f));
 
     Cubemap skybox;
     skybox.generateCubemap(util::resourcesPath / "textures/rustig/hdr");
 
-    Program shaderProg;
-    shaderProg.attachNew(GL_VERTEX_SHADER, ShaderFile::load("vertex/multiDraw.vert"));
-    shaderProg.attachNew(GL_FRAGMENT_SHADER, ShaderFile::load("fragment/basicRendering.frag"));
+    MaterialProgram shaderProg(ShaderFile::load("vertex/multiDraw.vert"), ShaderFile::load("fragment/basicRendering.frag"));
 
     Scene scene("sponza/sponza.obj");
     scene.reorderMeshes();
+    scene.setDepthPrepass(true);
     scene.setCamera(cam);
+    scene.getTextureStreaming().setUploadService(&uploadService);
 
     //auto l1 = Light::makePointLight({ 0.0f, 100.0f, 0.0f }, glm::vec3(100000.0f));
     auto l2 = Light::makeDirectionalLight();
@@ -38,20 +47,40 @@ int main()
     scene.addLight(l3);
     scene.addLight(l2);
 
+    HdrRenderTarget hdrTarget({ width, height });
+    DynamicResolution dynamicResolution(16.0f);
+
+    // alternative renderer, shades every pixel once in a compute pass
+    VisibilityBuffer visibilityBuffer({ width, height });
+    bool useVisibilityBuffer = false;
+
     Timer timer;
+    GlProfiler glProfiler; // disabled until enabled in its window
 
     while (float deltatime = window.update() > 0.0f)
     {
+        glProfiler.newFrame();
         timer.start();
 
         // --- RENDERING ---
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // the visibility buffer resolves at its full size, so it renders at full resolution
+        hdrTarget.setRenderScale(useVisibilityBuffer ? 1.0f : dynamicResolution.getScale());
+        hdrTarget.bind();
+        hdrTarget.clear();
         cam->update(window);
         cam->drawGuiWindow();
 
         skybox.renderAsSkybox(cam);
 
-        scene.render(shaderProg);
+        if (useVisibilityBuffer)
+            visibilityBuffer.render(scene);
+        else
+            scene.render(shaderProg);
+
+        hdrTarget.resolve(cam);
+        scene.getTextureResidency().update();
+        uploadService.update();
+        scene.updateTextureStreaming();
 
         if (/*l1->drawGuiWindow() ||*/ l2->drawGuiWindow() || l3->drawGuiWindow())
         {
@@ -64,6 +93,16 @@ int main()
 
         timer.stop();
         timer.drawGuiWindow(window);
+
+        dynamicResolution.update(timer.getTime());
+        dynamicResolution.drawGuiWindow();
+        hdrTarget.drawGuiWindow();
+        ImGui::Begin("Renderer");
+        ImGui::Checkbox("Visibility buffer", &useVisibilityBuffer);
+        ImGui::End();
+        glProfiler.drawGuiWindow();
+        scene.getTextureResidency().drawGuiWindow();
+        scene.getTextureStreaming().drawGuiWindow();
     }
     return 0;
 }
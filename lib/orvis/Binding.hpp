@@ -1,21 +1,50 @@
 #pragma once
 
 #include "glsp/glsp.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
 
 enum class BufferBinding : int
 {
-    modelMatrices = 50,
+    instanceData = 50,
     cameraParameters = 51,
     lights = 52,
     materials = 53,
     boundingBoxes = 54,
     indirectDraw = 55,
     lightIndex = 56,
+    multiDrawIndices = 57,
+    multiDrawVertices = 58,
+    multiDrawNormals = 59,
+    multiDrawTexCoords = 60,
+    postProcessing = 61,
+    views = 62,
+    materialResidency = 63,
+    materialUsage = 64,
+    materialFeedback = 65,
+    materialFeedbackParameters = 66
 };
 
 enum class TextureBinding : int
 {
-    skybox = 50
+    skybox = 50,
+    shadowDepth = 51,
+    screenColor = 52,
+    irradiance = 53,
+    specularEnvironment = 54,
+    brdfLut = 55,
+    bloom = 56
+};
+
+enum class ImageBinding : int
+{
+    filterInput = 0,
+    filterOutput = 1,
+    visibility = 2,
+    screenColor = 3,
+    bloom = 4   // one unit per bloom level (HdrRenderTarget::bloomLevels)
 };
 
 enum class VertexAttributeBinding : int
@@ -27,19 +56,79 @@ enum class VertexAttributeBinding : int
 
 namespace binding
 {
+    /** @brief Largest PCF kernel radius, a specialized filter is compiled for every radius up to this one. */
+    constexpr int maxPcfKernelSize = 10;
+
+    /**
+     * @brief Generates the normalized 1D gaussian PCF weights for every kernel radius as GLSL array constructor.
+     * Row k holds the 2k+1 weights of radius k, padded with zeros to 2*maxPcfKernelSize+2 entries.
+     */
+    inline std::string makePcfWeights()
+    {
+        const int width = 2 * maxPcfKernelSize + 2;
+
+        std::stringstream weights;
+        weights << std::fixed << std::setprecision(8);
+        weights << "float[" << maxPcfKernelSize + 1 << "][" << width << "](";
+        for (int k = 0; k <= maxPcfKernelSize; ++k)
+        {
+            const float twoSigmaSq = std::max(1.0f, static_cast<float>(k)) * 2.0f;
+            std::vector<float> row(width, 0.0f);
+            float kernelSum = 0.0f;
+            for (int i = -k; i <= k; ++i)
+            {
+                row[i + k] = std::exp(-(i * i) / twoSigmaSq);
+                kernelSum += row[i + k];
+            }
+
+            weights << (k == 0 ? "" : ", ") << "float[" << width << "](";
+            for (int i = 0; i < width; ++i)
+                weights << (i == 0 ? "" : ", ") << row[i] / kernelSum;
+            weights << ")";
+        }
+        weights << ")";
+
+        return weights.str();
+    }
+
     inline std::vector<glsp::definition> defaultShaderDefines = {
-        glsp::definition("MODELMATRICES_BINDING", static_cast<int>(BufferBinding::modelMatrices)),
+        glsp::definition("INSTANCE_DATA_BINDING", static_cast<int>(BufferBinding::instanceData)),
         glsp::definition("CAMERA_BINDING", static_cast<int>(BufferBinding::cameraParameters)),
         glsp::definition("LIGHTS_BINDING", static_cast<int>(BufferBinding::lights)),
         glsp::definition("MATERIALS_BINDING", static_cast<int>(BufferBinding::materials)),
         glsp::definition("BOUNDING_BOXES_BINDING", static_cast<int>(BufferBinding::boundingBoxes)),
         glsp::definition("INDIRECT_DRAW_BINDING", static_cast<int>(BufferBinding::indirectDraw)),
         glsp::definition("LIGHT_INDEX_BINDING", static_cast<int>(BufferBinding::lightIndex)),
+        glsp::definition("MULTIDRAW_INDICES_BINDING", static_cast<int>(BufferBinding::multiDrawIndices)),
+        glsp::definition("MULTIDRAW_VERTICES_BINDING", static_cast<int>(BufferBinding::multiDrawVertices)),
+        glsp::definition("MULTIDRAW_NORMALS_BINDING", static_cast<int>(BufferBinding::multiDrawNormals)),
+        glsp::definition("MULTIDRAW_TEXCOORDS_BINDING", static_cast<int>(BufferBinding::multiDrawTexCoords)),
+        glsp::definition("POST_PROCESSING_BINDING", static_cast<int>(BufferBinding::postProcessing)),
+        glsp::definition("VIEWS_BINDING", static_cast<int>(BufferBinding::views)),
+        glsp::definition("MATERIAL_RESIDENCY_BINDING", static_cast<int>(BufferBinding::materialResidency)),
+        glsp::definition("MATERIAL_USAGE_BINDING", static_cast<int>(BufferBinding::materialUsage)),
+        glsp::definition("MATERIAL_FEEDBACK_BINDING", static_cast<int>(BufferBinding::materialFeedback)),
+        glsp::definition("MATERIAL_FEEDBACK_PARAMETERS_BINDING", static_cast<int>(BufferBinding::materialFeedbackParameters)),
 
         glsp::definition("SKYBOX_BINDING", static_cast<int>(TextureBinding::skybox)),
+        glsp::definition("SHADOW_DEPTH_BINDING", static_cast<int>(TextureBinding::shadowDepth)),
+        glsp::definition("SCREEN_COLOR_BINDING", static_cast<int>(TextureBinding::screenColor)),
+        glsp::definition("IRRADIANCE_BINDING", static_cast<int>(TextureBinding::irradiance)),
+        glsp::definition("SPECULAR_ENVIRONMENT_BINDING", static_cast<int>(TextureBinding::specularEnvironment)),
+        glsp::definition("BRDF_LUT_BINDING", static_cast<int>(TextureBinding::brdfLut)),
+        glsp::definition("BLOOM_BINDING", static_cast<int>(TextureBinding::bloom)),
+
+        glsp::definition("FILTER_INPUT_IMAGE_BINDING", static_cast<int>(ImageBinding::filterInput)),
+        glsp::definition("FILTER_OUTPUT_IMAGE_BINDING", static_cast<int>(ImageBinding::filterOutput)),
+        glsp::definition("VISIBILITY_IMAGE_BINDING", static_cast<int>(ImageBinding::visibility)),
+        glsp::definition("SCREEN_COLOR_IMAGE_BINDING", static_cast<int>(ImageBinding::screenColor)),
+        glsp::definition("BLOOM_IMAGE_BINDING", static_cast<int>(ImageBinding::bloom)),
 
         glsp::definition("VERTEX_LAYOUT", static_cast<int>(VertexAttributeBinding::vertices)),
         glsp::definition("NORMAL_LAYOUT", static_cast<int>(VertexAttributeBinding::normals)),
-        glsp::definition("TEXCOORD_LAYOUT", static_cast<int>(VertexAttributeBinding::texCoords))
+        glsp::definition("TEXCOORD_LAYOUT", static_cast<int>(VertexAttributeBinding::texCoords)),
+
+        glsp::definition("MAX_PCF_KERNEL_SIZE", maxPcfKernelSize),
+        glsp::definition("PCF_WEIGHTS", makePcfWeights())
     };
 }
@@ -132,8 +132,20 @@ public:
      */
     void assign(const T& data, GLintptr index = 0);
 
+    /**
+     * @brief Assigns only the elements at the given indices of data to the same indices in the buffer.
+     * Neighbouring indices are coalesced into one glNamedBufferSubData call, gaps of up to maxGap unchanged elements
+     * are uploaded along to save calls.
+     * @param data The contents of the whole buffer, only the dirty elements are read.
+     * @param dirtyIndices Ascending indices of the elements that changed.
+     * @param maxGap The largest number of unchanged elements between two dirty ones that is uploaded instead of split.
+     */
+    void assignDirty(const std::vector<T>& data, const std::vector<GLsizeiptr>& dirtyIndices, GLsizeiptr maxGap = 8);
+
     /**
      * @brief Resize the buffer to the new size, using its current storage flags.
+     * @details The storage only grows (geometrically) if the new size exceeds the capacity, the existing
+     * contents are copied on the GPU with glCopyNamedBufferSubData.
      * @param newSize The new element count in this buffer.
      */
     void resize(size_t newSize);
@@ -163,6 +175,34 @@ public:
      */
     void resize(size_t newSize, const T& element, BufferStorageMask flags = GL_NONE_BIT);
 
+    /**
+     * @brief Makes sure that the buffer can hold the given number of elements without reallocating.
+     * @param capacity The element count to reserve storage for.
+     */
+    void reserve(size_t capacity);
+
+    /**
+     * @brief Appends one element to the end of the buffer, growing the storage geometrically if needed.
+     * Adds GL_DYNAMIC_STORAGE_BIT to the storage flags.
+     * @param element The element to append.
+     */
+    void push_back(const T& element);
+
+    /**
+     * @brief Appends the given data to the end of the buffer, growing the storage geometrically if needed.
+     * Adds GL_DYNAMIC_STORAGE_BIT to the storage flags.
+     * @param data A vector to be appended.
+     */
+    void append(const std::vector<T>& data);
+
+    /**
+     * @brief Appends the given data to the end of the buffer, growing the storage geometrically if needed.
+     * Adds GL_DYNAMIC_STORAGE_BIT to the storage flags.
+     * @param data A data pointer containing the elements to append.
+     * @param count The number of elements to append.
+     */
+    void append(const T* data, GLsizeiptr count);
+
     /**
      * @brief Binds the buffer to an opengl target at a given binding index using glBindBufferRange.
      * @param target The OpenGL buffer binding target.
@@ -200,6 +240,11 @@ public:
      */
     GLsizeiptr size() const;
 
+    /**
+     * @return The number of elements the current storage can hold.
+     */
+    GLsizeiptr capacity() const;
+
     /**
      * @brief Retrieves the full buffer data via glGetNamedBufferSubData.
      * @return A vector containing the buffer data.
@@ -220,8 +265,17 @@ public:
     GLbuffer id() const;
 
 private:
+    /**
+     * @brief Replaces the storage and copies the first min(size, capacity) elements to it on the GPU.
+     * @param fill If not null, immutable (non-dynamic) storage is initialized with this element.
+     */
+    void reallocate(GLsizeiptr capacity, BufferStorageMask flags, const T* fill);
+
+    static bool isDynamic(BufferStorageMask flags);
+
     BufferStorageMask   m_storageFlags = GL_NONE_BIT;
     GLsizeiptr          m_size = 0;
+    GLsizeiptr          m_capacity = 0;
     GLbuffer            m_buffer;
 };
 
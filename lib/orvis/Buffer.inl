@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 
 template <typename T>
@@ -35,6 +36,7 @@ Buffer<T>::Buffer(const T* data, GLsizeiptr count, BufferStorageMask flags)
         : Buffer()
 {
     m_size         = count;
+    m_capacity     = count;
     m_storageFlags = flags;
     glNamedBufferStorage(*m_buffer, sizeof(T) * count, data, flags);
 }
@@ -47,13 +49,15 @@ Buffer<T>::~Buffer()
 
 template <typename T>
 Buffer<T>::Buffer(const Buffer& other)
-        : Buffer(other.data(), other.m_storageFlags)
+        : Buffer()
 {
+    *this = other;
 }
 template <typename T>
 Buffer<T>::Buffer(Buffer&& other) noexcept
         : m_storageFlags(other.m_storageFlags)
         , m_size(other.m_size)
+        , m_capacity(other.m_capacity)
         , m_buffer(std::move(other.m_buffer))
 {
 }
@@ -64,9 +68,14 @@ Buffer<T>& Buffer<T>::operator=(const Buffer& other)
 	m_buffer = glCreateBufferRAII();
 
     m_size         = other.m_size;
+    m_capacity     = other.m_capacity;
     m_storageFlags = other.m_storageFlags;
-    glNamedBufferStorage(
-            *m_buffer, sizeof(T) * m_size, other.data().data(), m_storageFlags);
+    if (m_capacity > 0)
+    {
+        // copy on the GPU instead of reading the contents back
+        glNamedBufferStorage(*m_buffer, sizeof(T) * m_capacity, nullptr, m_storageFlags);
+        glCopyNamedBufferSubData(*other.m_buffer, *m_buffer, 0, 0, sizeof(T) * m_size);
+    }
     return *this;
 }
 template <typename T>
@@ -74,6 +83,7 @@ Buffer<T>& Buffer<T>::operator=(Buffer&& other) noexcept
 {
 	m_buffer.reset();
     m_size         = other.m_size;
+    m_capacity     = other.m_capacity;
     m_storageFlags = other.m_storageFlags;
     m_buffer       = std::move(other.m_buffer);
     return *this;
@@ -108,6 +118,20 @@ void Buffer<T>::assign(const T& data, GLintptr index)
     assign(&data, 1, index);
 }
 
+template <typename T>
+void Buffer<T>::assignDirty(const std::vector<T>& data, const std::vector<GLsizeiptr>& dirtyIndices, GLsizeiptr maxGap)
+{
+    for (size_t i = 0; i < dirtyIndices.size();)
+    {
+        const GLsizeiptr first = dirtyIndices[i];
+        GLsizeiptr last = first;
+        for (++i; i < dirtyIndices.size() && dirtyIndices[i] - last <= maxGap + 1; ++i)
+            last = dirtyIndices[i];
+
+        assign(data.data() + first, last - first + 1, first);
+    }
+}
+
 template <typename T>
 void Buffer<T>::resize(size_t newSize, BufferStorageMask flags)
 {
@@ -117,9 +141,20 @@ void Buffer<T>::resize(size_t newSize, BufferStorageMask flags)
 template <typename T>
 void Buffer<T>::resize(size_t newSize, const T& element, BufferStorageMask flags)
 {
-    auto oldData = data();
-    oldData.resize(newSize, element);
-    *this = Buffer(oldData, flags);
+    const auto count = static_cast<GLsizeiptr>(newSize);
+
+    // new flags need new storage, the size stays exact until the buffer grows again
+    if (flags != m_storageFlags)
+        reallocate(count, flags, &element);
+    else if (count > m_capacity || (count > m_size && !isDynamic(flags)))
+        reallocate(std::max(count, 2 * m_capacity), flags, &element);
+
+    if (count > m_size && isDynamic(m_storageFlags))
+    {
+        const std::vector<T> newElements(count - m_size, element);
+        glNamedBufferSubData(*m_buffer, m_size * sizeof(T), newElements.size() * sizeof(T), newElements.data());
+    }
+    m_size = count;
 }
 
 template <typename T>
@@ -131,9 +166,75 @@ void Buffer<T>::resize(size_t newSize)
 template <typename T>
 void Buffer<T>::resize(size_t newSize, const T& element)
 {
-    auto oldData = data();
-    oldData.resize(newSize, element);
-    *this = Buffer(oldData, m_storageFlags);
+    resize(newSize, element, m_storageFlags);
+}
+
+template <typename T>
+void Buffer<T>::reserve(size_t capacity)
+{
+    if (static_cast<GLsizeiptr>(capacity) > m_capacity)
+        reallocate(static_cast<GLsizeiptr>(capacity), m_storageFlags, nullptr);
+}
+
+template <typename T>
+void Buffer<T>::push_back(const T& element)
+{
+    append(&element, 1);
+}
+template <typename T>
+void Buffer<T>::append(const std::vector<T>& data)
+{
+    append(std::data(data), std::size(data));
+}
+template <typename T>
+void Buffer<T>::append(const T* data, GLsizeiptr count)
+{
+    if (count == 0)
+        return;
+
+    const GLsizeiptr newSize = m_size + count;
+    const BufferStorageMask flags = m_storageFlags | GL_DYNAMIC_STORAGE_BIT;
+    if (flags != m_storageFlags || newSize > m_capacity)
+        reallocate(std::max(newSize, 2 * m_capacity), flags, nullptr);
+
+    glNamedBufferSubData(*m_buffer, m_size * sizeof(T), count * sizeof(T), data);
+    m_size = newSize;
+}
+
+template <typename T>
+GLsizeiptr Buffer<T>::capacity() const
+{
+    return m_capacity;
+}
+
+template <typename T>
+void Buffer<T>::reallocate(GLsizeiptr capacity, BufferStorageMask flags, const T* fill)
+{
+    GLbuffer buffer = glCreateBufferRAII();
+    const GLsizeiptr keep = std::min(m_size, capacity);
+
+    if (capacity > 0)
+    {
+        // storage without GL_DYNAMIC_STORAGE_BIT can only be filled when it is created
+        std::vector<T> initialData;
+        if (fill && !isDynamic(flags))
+            initialData.assign(capacity, *fill);
+
+        glNamedBufferStorage(*buffer, sizeof(T) * capacity, initialData.empty() ? nullptr : initialData.data(), flags);
+        if (keep > 0)
+            glCopyNamedBufferSubData(*m_buffer, *buffer, 0, 0, sizeof(T) * keep);
+    }
+
+    m_buffer       = std::move(buffer);
+    m_storageFlags = flags;
+    m_capacity     = capacity;
+    m_size         = keep;
+}
+
+template <typename T>
+bool Buffer<T>::isDynamic(BufferStorageMask flags)
+{
+    return (flags & GL_DYNAMIC_STORAGE_BIT) != GL_NONE_BIT;
 }
 
 template <typename T>
@@ -146,7 +247,7 @@ void Buffer<T>::bind(GLenum target, std::variant<GLuint, BufferBinding> index, G
 {
     assert(offset + count <= m_size && "Invalid Size and/or offset.");
     const GLuint i = std::holds_alternative<GLuint>(index) ? std::get<GLuint>(index) : static_cast<GLuint>(std::get<BufferBinding>(index));
-    glBindBufferRange(target, i, *m_buffer, offset * sizeof(T), count * sizeof(T));
+    GlState::get().bindBufferRange(target, i, *m_buffer, offset * sizeof(T), count * sizeof(T));
 }
 
 template <typename T>
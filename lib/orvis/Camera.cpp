@@ -14,7 +14,7 @@ Camera::Camera(glm::mat4 projection, glm::vec3 position, glm::vec3 target, glm::
     , m_sensitivity(SENSITIVTY)
     , m_lastTime(glfwGetTime())
     , m_projection(projection)
-    , m_cameraBuffer({ position, gamma, forward(), exposure, view(), projection, glm::inverse(projection * glm::mat4(glm::mat3(view()))) }, GL_DYNAMIC_STORAGE_BIT)
+    , m_cameraBuffer(uploadsPerFrame)
 {
 }
 
@@ -92,10 +92,7 @@ void Camera::uploadToGpu()
 
     if (m_camHash != hash)
     {
-        const glm::mat4 v = view();
-        const glm::mat4 p = projection();
-        const glm::mat4 invVP = glm::inverse(p * glm::mat4(glm::mat3(v)));
-        m_cameraBuffer.assign({ position, gamma, forward(), exposure, v, p, invVP });
+        m_cameraBuffer.push(getGpuCamera());
         m_cameraBuffer.bind(GL_UNIFORM_BUFFER, BufferBinding::cameraParameters);
 
         m_camHash = hash;
@@ -104,12 +101,27 @@ void Camera::uploadToGpu()
 
 void Camera::uploadToGpu(const glm::mat4& view, const glm::mat4& proj)
 {
-    const glm::mat4 invVP = glm::inverse(proj * glm::mat4(glm::mat3(view)));
-    m_cameraBuffer.assign({ glm::vec3(view[3]), gamma, glm::vec3(glm::inverse(view)[2]), exposure, view, proj, invVP });
+    m_cameraBuffer.push(getGpuCamera(view, proj));
     m_cameraBuffer.bind(GL_UNIFORM_BUFFER, BufferBinding::cameraParameters);
     m_camHash = 0;
 }
 
+GpuCamera Camera::getGpuCamera() const
+{
+    const glm::mat4 v = view();
+    const glm::mat4 p = projection();
+    const glm::mat4 invVP = glm::inverse(p * glm::mat4(glm::mat3(v)));
+    return { position, gamma, forward(), exposure, v, p, invVP };
+}
+
+GpuCamera Camera::getGpuCamera(const glm::mat4& view, const glm::mat4& proj) const
+{
+    // the view matrix holds the view space translation, the eye and the view direction are in its inverse
+    const glm::mat4 invView = glm::inverse(view);
+    const glm::mat4 invVP = glm::inverse(proj * glm::mat4(glm::mat3(view)));
+    return { glm::vec3(invView[3]), gamma, -glm::vec3(invView[2]), exposure, view, proj, invVP };
+}
+
 void Camera::reset()
 {
     position = m_startPosition;
@@ -4,6 +4,7 @@
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
 #include "Buffer.hpp"
+#include "RingBuffer.hpp"
 
 enum class Direction
 {
@@ -67,6 +68,9 @@ public:
      */
     void update(GLFWwindow* window);
 
+    /** @brief The number of camera uploads per frame that can be in flight before the CPU waits for the GPU. */
+    static constexpr int uploadsPerFrame = 64;
+
     /**
     * @brief Puts camera data into a GpuCamera struct and uploads it to the GPU.
     * Also binds the buffer to binding::BufferBinding::cameraParameters.
@@ -83,6 +87,12 @@ public:
     */
     void uploadToGpu(const glm::mat4& view, const glm::mat4& proj);
 
+    /** @return The camera data as it is uploaded to the GPU. */
+    GpuCamera getGpuCamera() const;
+
+    /** @return The camera data for the given matrices, with gamma and exposure of this camera (e.g. for the eyes of a stereo view). */
+    GpuCamera getGpuCamera(const glm::mat4& view, const glm::mat4& proj) const;
+
     /**
      * @brief Resets camera to starting position and orientation
      */
@@ -152,7 +162,8 @@ private:
 
     glm::mat4 m_projection;
 
-    Buffer<GpuCamera> m_cameraBuffer;
+    // rewritten for every pass (main view, shadow maps, resolve), see Camera::uploadsPerFrame
+    RingBuffer<GpuCamera> m_cameraBuffer;
 
     size_t m_camHash = 0;
 };
@@ -1,10 +1,25 @@
 #include "Cubemap.hpp"
+#include "Util.hpp"
+#include "GlProfiler.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
 Cubemap::Cubemap() : m_skyboxShader(std::make_shared<Shader>(GL_FRAGMENT_SHADER, ShaderFile::load("fragment/skyBox.frag"))), m_screenFiller(m_skyboxShader)
 {
+    // no environment lighting until a cubemap is loaded
+    m_irradiance.clear(glm::vec4(0.0f));
+    for (int level = 0; level < specularLevels; ++level)
+        m_specularEnvironment.clear(level, glm::vec4(0.0f));
+    m_brdfLut.clear(glm::vec2(0.0f));
+
+    m_brdfLut.set(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    m_brdfLut.set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    m_brdfLut.set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
 
 void Cubemap::generateCubemap(const std::filesystem::path& path, const std::string& extension,
@@ -115,13 +130,178 @@ void Cubemap::generateCubemap(const std::filesystem::path& cubeMapSourcePath,
     }
 
     m_texture.generateMipmaps();
+
+    generateImageBasedLighting({ cubeMapSourcePath / (posX + extension), cubeMapSourcePath / (negX + extension),
+        cubeMapSourcePath / (posY + extension), cubeMapSourcePath / (negY + extension),
+        cubeMapSourcePath / (posZ + extension), cubeMapSourcePath / (negZ + extension) });
+}
+
+void Cubemap::generateImageBasedLighting(const std::array<std::filesystem::path, 6>& sourceFiles)
+{
+    // 64 bit FNV-1a, std::hash differs between standard libraries and builds
+    uint64_t key = 0xcbf29ce484222325ull;
+    const auto hashBytes = [&key](const std::string& bytes)
+    {
+        for (const char byte : bytes)
+        {
+            key ^= static_cast<uint8_t>(byte);
+            key *= 0x100000001b3ull;
+        }
+    };
+    const auto hashFile = [&hashBytes](const std::filesystem::path& file)
+    {
+        std::ifstream stream(file, std::ios::binary);
+        hashBytes(std::string((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>()));
+    };
+
+    // the file format, the texture sizes and the filter shader are part of the key, changing them invalidates the cache
+    std::stringstream parameters;
+    parameters << cacheVersion << ' ' << irradianceSize << ' ' << specularSize << ' ' << specularLevels << ' ' << brdfLutSize;
+    hashBytes(parameters.str());
+    hashFile(util::shadersPath / "compute" / "imageBasedLighting.comp");
+    for (const auto& file : sourceFiles)
+        hashFile(file);
+
+    std::stringstream cacheName;
+    cacheName << "ibl_" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    const auto cacheFile = util::resourcesPath / "cache" / cacheName.str();
+
+    if (loadImageBasedLighting(cacheFile))
+        return;
+
+    computeImageBasedLighting();
+    saveImageBasedLighting(cacheFile);
+}
+
+void Cubemap::computeImageBasedLighting()
+{
+    const auto makeProgram = [](const std::string& variant)
+    {
+        std::vector<glsp::definition> definitions = binding::defaultShaderDefines;
+        definitions.emplace_back(variant);
+        definitions.emplace_back("SPECULAR_SIZE", specularSize);
+        definitions.emplace_back("SPECULAR_LEVELS", specularLevels);
+
+        Program program;
+        program.attach(std::make_shared<Shader>(GL_COMPUTE_SHADER, ShaderFile::load("compute/imageBasedLighting.comp"), definitions));
+        return program;
+    };
+
+    m_texture.bind(TextureBinding::skybox);
+
+    const Program irradianceProgram = makeProgram("IRRADIANCE");
+    m_irradiance.bindImage(ImageBinding::filterOutput, 0, true, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    irradianceProgram.use();
+    glDispatchCompute((irradianceSize + 7) / 8, (irradianceSize + 7) / 8, 6);
+
+    const Program specularProgram = makeProgram("SPECULAR");
+    specularProgram.use();
+    for (int level = 0; level < specularLevels; ++level)
+    {
+        const int levelSize = std::max(specularSize >> level, 1);
+        m_specularEnvironment.bindImage(ImageBinding::filterOutput, level, true, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        glDispatchCompute((levelSize + 7) / 8, (levelSize + 7) / 8, 6);
+    }
+
+    const Program brdfLutProgram = makeProgram("BRDF_LUT");
+    m_brdfLut.bindImage(ImageBinding::filterOutput, 0, false, 0, GL_WRITE_ONLY, GL_RG16F);
+    brdfLutProgram.use();
+    glDispatchCompute((brdfLutSize + 7) / 8, (brdfLutSize + 7) / 8, 1);
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+}
+
+namespace
+{
+    struct CachedImage
+    {
+        const Texture& texture;
+        int level;
+        int layers;
+        GLenum format;
+        int texelSize;
+
+        glm::ivec2 size() const { return glm::max(glm::ivec2(texture.getSize()) >> level, glm::ivec2(1)); }
+        size_t bytes() const { return static_cast<size_t>(size().x) * size().y * layers * texelSize; }
+    };
+
+    // all textures are stored as half floats in this order
+    std::vector<CachedImage> getCachedImages(const Texture& irradiance, const Texture& specular, const Texture& brdfLut)
+    {
+        std::vector<CachedImage> images{ { irradiance, 0, 6, GL_RGBA, 8 } };
+        for (int level = 0; level < Cubemap::specularLevels; ++level)
+            images.push_back({ specular, level, 6, GL_RGBA, 8 });
+        images.push_back({ brdfLut, 0, 1, GL_RG, 4 });
+        return images;
+    }
+}
+
+bool Cubemap::loadImageBasedLighting(const std::filesystem::path& cacheFile)
+{
+    std::ifstream stream(cacheFile, std::ios::binary);
+    if (!stream)
+        return false;
+
+    const std::string content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    const auto images = getCachedImages(m_irradiance, m_specularEnvironment, m_brdfLut);
+    size_t expectedSize = 0;
+    for (const auto& image : images)
+        expectedSize += image.bytes();
+    if (content.size() != expectedSize)
+        return false;
+
+    size_t offset = 0;
+    for (const auto& image : images)
+    {
+        if (image.layers == 1)
+            image.texture.assign2D(image.level, { 0, 0 }, image.size(), image.format, GL_HALF_FLOAT, content.data() + offset);
+        else
+            image.texture.assign3D(image.level, { 0, 0, 0 }, { image.size(), image.layers }, image.format, GL_HALF_FLOAT, content.data() + offset);
+        offset += image.bytes();
+    }
+
+    std::cout << "Loaded image based lighting from " << cacheFile.string() << std::endl;
+    return true;
+}
+
+void Cubemap::saveImageBasedLighting(const std::filesystem::path& cacheFile) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(cacheFile.parent_path(), error);
+    std::ofstream stream(cacheFile, std::ios::binary);
+    if (error || !stream)
+    {
+        std::cout << "WARNING: Could not write image based lighting cache " << cacheFile.string() << "\n";
+        return;
+    }
+
+    std::vector<char> pixels;
+    for (const auto& image : getCachedImages(m_irradiance, m_specularEnvironment, m_brdfLut))
+    {
+        pixels.resize(image.bytes());
+        glGetTextureImage(*image.texture.id(), image.level, image.format, GL_HALF_FLOAT, static_cast<GLsizei>(pixels.size()), pixels.data());
+        stream.write(pixels.data(), static_cast<std::streamsize>(pixels.size()));
+    }
 }
 
 void Cubemap::renderAsSkybox(const std::shared_ptr<Camera>& camera)
 {
+    GlProfiler::Scope profilerScope("Cubemap::renderAsSkybox");
     m_screenFiller.setCamera(camera);
     m_texture.bind(TextureBinding::skybox);
+    bindImageBasedLighting();
     m_screenFiller.render();
 }
 
+void Cubemap::bindImageBasedLighting() const
+{
+    m_irradiance.bind(TextureBinding::irradiance);
+    m_specularEnvironment.bind(TextureBinding::specularEnvironment);
+    m_brdfLut.bind(TextureBinding::brdfLut);
+}
+
 const Texture& Cubemap::getTexture() const { return m_texture; }
+const Texture& Cubemap::getIrradianceTexture() const { return m_irradiance; }
+const Texture& Cubemap::getSpecularEnvironmentTexture() const { return m_specularEnvironment; }
+const Texture& Cubemap::getBrdfLut() const { return m_brdfLut; }
@@ -37,6 +37,7 @@ public:
      * Example: "negz". This is also the thefault value for this parameter.
      * @details In this function the strings get concatinated to load a face of the cubemap.
      * Example "/textures/indoor/posx.hdr
+     * Afterwards the image based lighting is generated, see Cubemap::generateImageBasedLighting.
      */
     void generateCubemap(const std::filesystem::path& cubeMapSourcePath,
         const std::string& extension = ".hdr", const std::string& posX = "posx",
@@ -63,10 +64,40 @@ public:
      */
     void renderAsSkybox(const std::shared_ptr<Camera>& camera);
 
+    /** @brief Binds the irradiance map, the prefiltered specular environment and the BRDF lookup table
+     * used by pbrShading.glsl. Also called by Cubemap::renderAsSkybox.
+     */
+    void bindImageBasedLighting() const;
+
     const Texture& getTexture() const;
+    const Texture& getIrradianceTexture() const;
+    const Texture& getSpecularEnvironmentTexture() const;
+    const Texture& getBrdfLut() const;
+
+    static constexpr int irradianceSize = 32;
+    static constexpr int specularSize = 128;
+    static constexpr int specularLevels = 5;    //!< Level i of the specular environment is prefiltered for roughness i / (specularLevels - 1).
+    static constexpr int brdfLutSize = 256;
+    static constexpr int cacheVersion = 1;      //!< Increment when the layout of the cache files changes.
 
 private:
+    /** @brief Loads the image based lighting from the cache or precomputes and caches it.
+     * The cache file lives in res/cache and is named after a hash of the source files' contents, the filter shader
+     * and Cubemap::cacheVersion, so it is recomputed whenever one of them changes.
+     */
+    void generateImageBasedLighting(const std::array<std::filesystem::path, 6>& sourceFiles);
+
+    /** @brief Precomputes irradiance, specular environment and BRDF lookup table with compute shaders. */
+    void computeImageBasedLighting();
+
+    /** @return false if the cache file does not exist or does not match the texture sizes. */
+    bool loadImageBasedLighting(const std::filesystem::path& cacheFile);
+    void saveImageBasedLighting(const std::filesystem::path& cacheFile) const;
+
     Texture                     m_texture{ GL_TEXTURE_CUBE_MAP, GL_R11F_G11F_B10F, glm::ivec2(1, 1) };
+    Texture                     m_irradiance{ GL_TEXTURE_CUBE_MAP, GL_RGBA16F, glm::ivec2(irradianceSize), 1 };
+    Texture                     m_specularEnvironment{ GL_TEXTURE_CUBE_MAP, GL_RGBA16F, glm::ivec2(specularSize), specularLevels };
+    Texture                     m_brdfLut{ GL_TEXTURE_2D, GL_RG16F, glm::ivec2(brdfLutSize), 1 };
     std::shared_ptr<Shader>     m_skyboxShader;
     ScreenFiller                m_screenFiller;
 };
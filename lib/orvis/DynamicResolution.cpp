@@ -0,0 +1,75 @@
+#include "DynamicResolution.hpp"
+#include <algorithm>
+#include <cmath>
+#include <imgui.h>
+
+namespace
+{
+    constexpr float smoothing = 0.1f;         // weight of the newest frame time
+    constexpr float tolerance = 0.05f;        // relative deviation from the target that is accepted
+    constexpr float maxScaleChange = 0.05f;   // per frame
+}
+
+DynamicResolution::DynamicResolution(float targetTime, float minScale, float maxScale)
+    : m_targetTime(targetTime), m_minScale(minScale), m_maxScale(maxScale), m_scale(maxScale)
+{
+}
+
+float DynamicResolution::update(float gpuTime)
+{
+    if (!m_enabled || gpuTime <= 0.0f)
+        return m_scale;
+
+    m_smoothedTime = m_smoothedTime == 0.0f ? gpuTime : (1.0f - smoothing) * m_smoothedTime + smoothing * gpuTime;
+
+    // the time scales with the pixel count, i.e. with the square of the scale per axis
+    const float ratio = m_targetTime / m_smoothedTime;
+    if (std::abs(ratio - 1.0f) > tolerance)
+    {
+        const float desiredScale = m_scale * std::sqrt(ratio);
+        m_scale = std::clamp(desiredScale, m_scale - maxScaleChange, m_scale + maxScaleChange);
+        m_scale = std::clamp(m_scale, m_minScale, m_maxScale);
+    }
+
+    return m_scale;
+}
+
+float DynamicResolution::getScale() const
+{
+    return m_enabled ? m_scale : m_maxScale;
+}
+
+void DynamicResolution::setTargetTime(float targetTime)
+{
+    m_targetTime = std::max(targetTime, 0.1f);
+}
+
+float DynamicResolution::getTargetTime() const
+{
+    return m_targetTime;
+}
+
+bool DynamicResolution::drawGuiWindow()
+{
+    ImGui::SetNextWindowSize(ImVec2(300, 100), ImGuiSetCond_FirstUseEver);
+    ImGui::Begin("Dynamic Resolution");
+    const bool changed = drawGuiContent();
+    ImGui::End();
+    return changed;
+}
+
+bool DynamicResolution::drawGuiContent()
+{
+    ImGui::PushID(this);
+
+    bool changed = ImGui::Checkbox("Enabled", &m_enabled);
+    if (ImGui::SliderFloat("Target time (ms)", &m_targetTime, 1.0f, 50.0f))
+    {
+        setTargetTime(m_targetTime);
+        changed = true;
+    }
+    ImGui::Value("Render scale", getScale());
+
+    ImGui::PopID();
+    return changed;
+}
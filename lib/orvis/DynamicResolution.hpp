@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * @brief Adapts the render scale of a HdrRenderTarget to meet a GPU frame time budget.
+ * @details Feed it the GPU time of every frame (e.g. from Timer::getTime). The time is smoothed and the scale is
+ * adjusted assuming that the GPU time is proportional to the number of rendered pixels. Small deviations are ignored
+ * and the change per frame is limited, so the resolution does not oscillate.
+ */
+class DynamicResolution
+{
+public:
+    /**
+     * @param targetTime The GPU frame time to aim for in milliseconds.
+     * @param minScale The smallest render scale per axis.
+     * @param maxScale The largest render scale per axis.
+     */
+    explicit DynamicResolution(float targetTime = 16.0f, float minScale = 0.5f, float maxScale = 1.0f);
+
+    /**
+     * @brief Updates the render scale with the GPU time of the last frame.
+     * @param gpuTime The GPU time of the last frame in milliseconds.
+     * @return The new render scale.
+     */
+    float update(float gpuTime);
+
+    /** @return The render scale per axis, pass it to HdrRenderTarget::setRenderScale. */
+    float getScale() const;
+
+    void  setTargetTime(float targetTime);
+    float getTargetTime() const;
+
+    /**
+    * @brief Draws a ImGui-window containing the controller parameters.
+    * @return true if the parameters were changed.
+    */
+    bool drawGuiWindow();
+
+    /**
+    * @brief Draws the ImGui-content containing the controller parameters.
+    * @return true if the parameters were changed.
+    */
+    bool drawGuiContent();
+
+private:
+    float m_targetTime;
+    float m_minScale;
+    float m_maxScale;
+    float m_scale;
+    float m_smoothedTime = 0.0f;
+    bool m_enabled = true;
+};
@@ -1,4 +1,5 @@
 #include "FrameBuffer.hpp"
+#include "GlState.hpp"
 #include <algorithm>
 #include <iostream>
 
@@ -107,9 +108,9 @@ void FrameBuffer::resize(glm::ivec2 size)
     check();
 }
 
-void FrameBuffer::bind() const { glBindFramebuffer(GL_FRAMEBUFFER, *m_fbo); }
+void FrameBuffer::bind() const { GlState::get().bindFramebuffer(GL_FRAMEBUFFER, *m_fbo); }
 
-void FrameBuffer::unbind() { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+void FrameBuffer::unbind() { GlState::get().bindFramebuffer(GL_FRAMEBUFFER, 0); }
 
 GLframebuffer FrameBuffer::id() const { return m_fbo; }
 
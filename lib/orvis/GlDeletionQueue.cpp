@@ -0,0 +1,99 @@
+#include "GlDeletionQueue.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+GlDeletionQueue& GlDeletionQueue::get()
+{
+    static GlDeletionQueue queue;
+    return queue;
+}
+
+void GlDeletionQueue::enqueue(Deleter deleter, GLuint id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_released.push_back({ deleter, id });
+}
+
+void GlDeletionQueue::enqueue(GLsync sync)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_releasedSyncs.push_back(sync);
+}
+
+void GlDeletionQueue::flush()
+{
+    Batch batch;
+    std::vector<GLsync> syncs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        batch.deletions.swap(m_released);
+        syncs.swap(m_releasedSyncs);
+    }
+    for (const GLsync sync : syncs)
+        glDeleteSync(sync);
+
+    if (!batch.deletions.empty())
+    {
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+        m_batches.push_back(std::move(batch));
+    }
+
+    // fences signal in order, so the first pending one blocks all later batches
+    while (!m_batches.empty() && glClientWaitSync(m_batches.front().fence, GL_NONE_BIT, 0) != GL_TIMEOUT_EXPIRED)
+    {
+        glDeleteSync(m_batches.front().fence);
+        deleteAll(m_batches.front().deletions);
+        m_batches.pop_front();
+    }
+}
+
+void GlDeletionQueue::finish()
+{
+    glFinish();
+
+    std::vector<Deletion> released;
+    std::vector<GLsync> syncs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        released.swap(m_released);
+        syncs.swap(m_releasedSyncs);
+    }
+    for (const GLsync sync : syncs)
+        glDeleteSync(sync);
+    for (auto& batch : m_batches)
+    {
+        glDeleteSync(batch.fence);
+        deleteAll(batch.deletions);
+    }
+    m_batches.clear();
+    deleteAll(released);
+}
+
+size_t GlDeletionQueue::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t count = m_released.size() + m_releasedSyncs.size();
+    for (const auto& batch : m_batches)
+        count += batch.deletions.size();
+    return count;
+}
+
+void GlDeletionQueue::deleteAll(std::vector<Deletion>& deletions)
+{
+    std::sort(deletions.begin(), deletions.end(),
+        [](const Deletion& a, const Deletion& b) { return std::less<Deleter>()(a.deleter, b.deleter); });
+
+    std::vector<GLuint> ids;
+    for (auto first = deletions.begin(); first != deletions.end();)
+    {
+        const auto last = std::find_if(first, deletions.end(),
+            [deleter = first->deleter](const Deletion& d) { return d.deleter != deleter; });
+
+        ids.clear();
+        std::transform(first, last, std::back_inserter(ids), [](const Deletion& d) { return d.id; });
+        first->deleter(static_cast<GLsizei>(ids.size()), ids.data());
+        first = last;
+    }
+}
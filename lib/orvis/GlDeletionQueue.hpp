@@ -0,0 +1,71 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <glbinding/gl/gl.h>
+
+using namespace gl;
+
+/**
+ * @brief Defers the deletion of OpenGL objects until the GPU has finished all commands issued before their release.
+ * @details The OpenGL_RAII handles do not delete their object when the last reference dies, they enqueue it here from
+ * whatever thread they die on, without calling OpenGL. GlDeletionQueue::flush, called once per frame on the render
+ * thread by Window::update, fences the objects released since the last flush and deletes the ones whose fence has
+ * signaled, batched per object type. So objects whose bindless handles are still referenced by commands in flight
+ * stay alive, and worker threads never delete objects themselves. Vertex arrays and framebuffers are not shared between
+ * contexts and therefore have to be created on the render thread.
+ */
+class GlDeletionQueue
+{
+public:
+    /** @brief Deletes a batch of objects of one type, e.g. via glDeleteTextures. */
+    using Deleter = void(*)(GLsizei count, const GLuint* ids);
+
+    /** @return The process wide queue, objects are shared between the contexts of the application. */
+    static GlDeletionQueue& get();
+
+    GlDeletionQueue(const GlDeletionQueue& other) = delete;
+    GlDeletionQueue& operator=(const GlDeletionQueue& other) = delete;
+
+    /** @brief Schedules the deletion of an object. Thread-safe and does not call OpenGL. */
+    void enqueue(Deleter deleter, GLuint id);
+
+    /**
+     * @brief Schedules the deletion of a sync object with the next flush. Thread-safe and does not call OpenGL.
+     * OpenGL keeps a sync object alive until it is not waited on anymore, so it needs no fence of its own.
+     */
+    void enqueue(GLsync sync);
+
+    /** @brief Fences the objects released since the last flush and deletes the ones that are not in use anymore. */
+    void flush();
+
+    /** @brief Waits for the GPU and deletes all queued objects, e.g. before the context is destroyed. */
+    void finish();
+
+    /** @return The number of objects that were released but not deleted yet. */
+    size_t getPendingCount() const;
+
+private:
+    struct Deletion
+    {
+        Deleter deleter;
+        GLuint id;
+    };
+
+    struct Batch
+    {
+        std::vector<Deletion> deletions;
+        GLsync fence = nullptr;
+    };
+
+    GlDeletionQueue() = default;
+
+    /** @brief Calls every deleter once with all ids of its type. */
+    static void deleteAll(std::vector<Deletion>& deletions);
+
+    mutable std::mutex    m_mutex;
+    std::vector<Deletion> m_released;   // since the last flush, filled from any thread
+    std::vector<GLsync>   m_releasedSyncs;
+    std::deque<Batch>     m_batches;    // render thread only, in fence order
+};
@@ -0,0 +1,223 @@
+#include "GlProfiler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+#include <imgui.h>
+#include <glbinding/AbstractFunction.h>
+#include <glbinding/callbacks.h>
+#include <glbinding/FunctionCall.h>
+#include "Util.hpp"
+
+namespace
+{
+    GlProfiler* instance = nullptr;
+    thread_local const char* currentScope = "(no scope)";
+
+    // functions that make the CPU wait for the GPU or read back data
+    constexpr const char* stallPrefixes[] = { "glGet", "glReadPixels", "glReadnPixels", "glFinish", "glClientWaitSync",
+        "glMapBuffer", "glMapNamedBuffer" };
+}
+
+GlProfiler::Scope::Scope(const char* name) : m_previous(currentScope)
+{
+    currentScope = name;
+}
+
+GlProfiler::Scope::~Scope()
+{
+    currentScope = m_previous;
+}
+
+GlProfiler::GlProfiler()
+{
+    assert(!instance && "Only one GlProfiler can exist at a time");
+    instance = this;
+}
+
+GlProfiler::~GlProfiler()
+{
+    setEnabled(false);
+    instance = nullptr;
+}
+
+void GlProfiler::setEnabled(bool enabled)
+{
+    if (enabled == m_enabled)
+        return;
+
+    m_enabled = enabled;
+    m_currentFrame.clear();
+    m_lastFrame.clear();
+
+    if (enabled)
+    {
+        m_thread = std::this_thread::get_id();
+        glbinding::setBeforeCallback([](const glbinding::FunctionCall&) { instance->before(); });
+        glbinding::setAfterCallback([](const glbinding::FunctionCall& call) { instance->after(call.function); });
+        glbinding::setCallbackMask(glbinding::CallbackMask::Before | glbinding::CallbackMask::After);
+    }
+    else
+    {
+        glbinding::setCallbackMask(glbinding::CallbackMask::None);
+    }
+}
+
+bool GlProfiler::isEnabled() const
+{
+    return m_enabled;
+}
+
+void GlProfiler::before()
+{
+    if (std::this_thread::get_id() == m_thread)
+        m_callStart = std::chrono::steady_clock::now();
+}
+
+void GlProfiler::after(const glbinding::AbstractFunction* function)
+{
+    if (std::this_thread::get_id() != m_thread)
+        return;
+
+    Entry& entry = m_currentFrame[{ currentScope, function }];
+    ++entry.calls;
+    entry.time += std::chrono::steady_clock::now() - m_callStart;
+}
+
+bool GlProfiler::isStall(const std::string& function)
+{
+    return std::any_of(std::begin(stallPrefixes), std::end(stallPrefixes),
+        [&function](const char* prefix) { return function.compare(0, std::strlen(prefix), prefix) == 0; });
+}
+
+void GlProfiler::newFrame()
+{
+    m_lastStateStatistics = GlState::get().getStatistics();
+    GlState::get().resetStatistics();
+
+    if (!m_enabled)
+        return;
+
+    m_lastFrame.clear();
+    for (const auto& [key, entry] : m_currentFrame)
+    {
+        CallStatistics statistics;
+        statistics.scope = key.scope;
+        statistics.function = key.function->name();
+        statistics.calls = entry.calls;
+        statistics.milliseconds = std::chrono::duration<double, std::milli>(entry.time).count();
+        statistics.stall = isStall(statistics.function);
+        m_lastFrame.push_back(std::move(statistics));
+    }
+    std::sort(m_lastFrame.begin(), m_lastFrame.end(),
+        [](const CallStatistics& a, const CallStatistics& b) { return a.milliseconds > b.milliseconds; });
+
+    m_currentFrame.clear();
+}
+
+const std::vector<GlProfiler::CallStatistics>& GlProfiler::getFrameStatistics() const
+{
+    return m_lastFrame;
+}
+
+const GlStateStatistics& GlProfiler::getStateStatistics() const
+{
+    return m_lastStateStatistics;
+}
+
+void GlProfiler::saveCsv(const std::filesystem::path& filename) const
+{
+    std::ofstream file(filename);
+    if (!file)
+        throw std::runtime_error("Could not write " + filename.string());
+
+    file << "scope,function,calls,cpu_ms,stall\n";
+    for (const auto& statistics : m_lastFrame)
+    {
+        file << statistics.scope << ',' << statistics.function << ',' << statistics.calls << ','
+            << statistics.milliseconds << ',' << (statistics.stall ? 1 : 0) << '\n';
+    }
+}
+
+bool GlProfiler::drawGuiWindow()
+{
+    ImGui::SetNextWindowSize(ImVec2(500, 300), ImGuiSetCond_FirstUseEver);
+    ImGui::Begin("GL Profiler");
+    const bool changed = drawGuiContent();
+    ImGui::End();
+    return changed;
+}
+
+bool GlProfiler::drawGuiContent()
+{
+    ImGui::PushID(this);
+
+    bool enabled = m_enabled;
+    const bool changed = ImGui::Checkbox("Enabled", &enabled);
+    if (changed)
+        setEnabled(enabled);
+
+    size_t calls = 0;
+    size_t stalls = 0;
+    double milliseconds = 0.0;
+    for (const auto& statistics : m_lastFrame)
+    {
+        calls += statistics.calls;
+        milliseconds += statistics.milliseconds;
+        stalls += statistics.stall ? statistics.calls : 0;
+    }
+    ImGui::Text("%zu calls, %.3f ms in the driver, %zu stalling calls", calls, milliseconds, stalls);
+    ImGui::Text("%zu state changes issued, %zu redundant ones skipped", m_lastStateStatistics.issued, m_lastStateStatistics.skipped);
+
+    if (ImGui::Button("Save CSV"))
+    {
+        // next to the res directory, so the profiles do not end up in the resources
+        const auto path = util::resourcesPath.parent_path() / ("glProfile_" + std::to_string(time(nullptr)) + ".csv");
+        try
+        {
+            saveCsv(path);
+            m_saveStatus = "Saved " + path.string();
+        }
+        catch (const std::exception& e)
+        {
+            m_saveStatus = e.what();
+        }
+    }
+    if (!m_saveStatus.empty())
+    {
+        ImGui::SameLine();
+        ImGui::Text("%s", m_saveStatus.c_str());
+    }
+
+    ImGui::Columns(4, "calls");
+    ImGui::Text("Scope");
+    ImGui::NextColumn();
+    ImGui::Text("Function");
+    ImGui::NextColumn();
+    ImGui::Text("Calls");
+    ImGui::NextColumn();
+    ImGui::Text("CPU ms");
+    ImGui::NextColumn();
+    ImGui::Separator();
+    for (const auto& statistics : m_lastFrame)
+    {
+        ImGui::Text("%s", statistics.scope.c_str());
+        ImGui::NextColumn();
+        if (statistics.stall)
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.2f, 1.0f), "%s", statistics.function.c_str());
+        else
+            ImGui::Text("%s", statistics.function.c_str());
+        ImGui::NextColumn();
+        ImGui::Text("%zu", statistics.calls);
+        ImGui::NextColumn();
+        ImGui::Text("%.4f", statistics.milliseconds);
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+
+    ImGui::PopID();
+    return changed;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "GlState.hpp"
+
+namespace glbinding
+{
+    class AbstractFunction;
+}
+
+/**
+ * @brief Opt-in instrumentation of all OpenGL calls through the glbinding before/after callbacks.
+ * @details While enabled, every call of the thread that enabled the profiler is counted and the CPU time spent inside
+ * the driver is measured per function and per GlProfiler::Scope (the call site). Calls that stall the CPU until the
+ * GPU caught up (glGet*, glReadPixels, glFinish, ...) are flagged. The statistics of the last frame are shown by
+ * GlProfiler::drawGuiWindow and can be written to a CSV file. The state changes that GlState issued and skipped are
+ * collected every frame, even while the profiler is disabled. Only one profiler can exist at a time.
+ */
+class GlProfiler
+{
+public:
+    /** @brief Statistics of one function called from one scope during one frame. */
+    struct CallStatistics
+    {
+        std::string scope;
+        std::string function;
+        size_t calls = 0;
+        double milliseconds = 0.0;  //!< CPU time spent inside the driver.
+        bool stall = false;         //!< True for functions that wait for the GPU or read back data.
+    };
+
+    /**
+     * @brief Names the call site for all GL calls of the current thread until it is destroyed. Scopes can be nested,
+     * calls are attributed to the innermost one. Costs nothing but a pointer swap if the profiler is disabled.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+
+        Scope(const Scope& other) = delete;
+        Scope& operator=(const Scope& other) = delete;
+
+    private:
+        const char* m_previous;
+    };
+
+    /** @brief Creates a disabled profiler. */
+    GlProfiler();
+
+    /** @brief Disables the callbacks. */
+    ~GlProfiler();
+
+    GlProfiler(const GlProfiler& other) = delete;
+    GlProfiler& operator=(const GlProfiler& other) = delete;
+
+    /** @brief Installs or removes the glbinding callbacks, only calls of the calling thread are recorded. */
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    /**
+     * @brief Publishes the statistics of the finished frame and starts a new one. Also takes over and resets the
+     * GlState statistics of the calling thread. Call once per frame.
+     */
+    void newFrame();
+
+    /** @return The statistics of the last finished frame, sorted by time. */
+    const std::vector<CallStatistics>& getFrameStatistics() const;
+
+    /** @return The state changes GlState issued and skipped during the last finished frame. */
+    const GlStateStatistics& getStateStatistics() const;
+
+    /**
+     * @brief Writes the statistics of the last finished frame to a CSV file.
+     * Throws std::runtime_error if the file cannot be written.
+     * @param filename The file path, existing files are overwritten.
+     */
+    void saveCsv(const std::filesystem::path& filename) const;
+
+    /**
+    * @brief Draws a ImGui-window with the call statistics of the last frame.
+    * @return true if the profiler was enabled or disabled.
+    */
+    bool drawGuiWindow();
+
+    /**
+    * @brief Draws the ImGui-content with the call statistics of the last frame.
+    * @return true if the profiler was enabled or disabled.
+    */
+    bool drawGuiContent();
+
+private:
+    struct Key
+    {
+        const char* scope;
+        const glbinding::AbstractFunction* function;
+        bool operator==(const Key& other) const { return scope == other.scope && function == other.function; }
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return std::hash<const void*>{}(key.scope) ^ (std::hash<const void*>{}(key.function) << 1);
+        }
+    };
+    struct Entry
+    {
+        size_t calls = 0;
+        std::chrono::steady_clock::duration time{ 0 };
+    };
+
+    void before();
+    void after(const glbinding::AbstractFunction* function);
+
+    static bool isStall(const std::string& function);
+
+    bool m_enabled = false;
+    std::thread::id m_thread;
+    std::chrono::steady_clock::time_point m_callStart;
+    std::unordered_map<Key, Entry, KeyHash> m_currentFrame;
+    std::vector<CallStatistics> m_lastFrame;
+    GlStateStatistics m_lastStateStatistics;
+    std::string m_saveStatus;   // result of the last "Save CSV" click, shown next to the button
+};
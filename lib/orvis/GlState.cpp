@@ -0,0 +1,226 @@
+#include "GlState.hpp"
+
+GlState& GlState::get()
+{
+    thread_local GlState state;
+    return state;
+}
+
+bool GlState::change(bool changed)
+{
+    ++(changed ? m_statistics.issued : m_statistics.skipped);
+    return changed;
+}
+
+void GlState::useProgram(GLuint program)
+{
+    if (change(m_program != program))
+    {
+        glUseProgram(program);
+        m_program = program;
+    }
+}
+
+void GlState::bindVertexArray(GLuint vertexArray)
+{
+    if (change(m_vertexArray != vertexArray))
+    {
+        glBindVertexArray(vertexArray);
+        m_vertexArray = vertexArray;
+    }
+}
+
+void GlState::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    const bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    const bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    const bool changed = (draw && m_drawFramebuffer != framebuffer) || (read && m_readFramebuffer != framebuffer);
+
+    if (change(changed))
+    {
+        glBindFramebuffer(target, framebuffer);
+        if (draw)
+            m_drawFramebuffer = framebuffer;
+        if (read)
+            m_readFramebuffer = framebuffer;
+    }
+}
+
+void GlState::bindBuffer(GLenum target, GLuint buffer)
+{
+    const auto current = m_buffers.find(target);
+    if (change(current == m_buffers.end() || current->second != buffer))
+    {
+        glBindBuffer(target, buffer);
+        m_buffers[target] = buffer;
+    }
+}
+
+void GlState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    const auto current = m_bufferRanges.find({ target, index });
+    const bool changed = current == m_bufferRanges.end() || current->second.buffer != buffer
+        || current->second.offset != offset || current->second.size != size;
+
+    if (change(changed))
+    {
+        glBindBufferRange(target, index, buffer, offset, size);
+        m_bufferRanges[{ target, index }] = { buffer, offset, size };
+        m_buffers[target] = buffer;
+    }
+}
+
+GLuint GlState::getDrawFramebuffer()
+{
+    if (!m_drawFramebuffer)
+    {
+        GLint framebuffer;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        m_drawFramebuffer = static_cast<GLuint>(framebuffer);
+    }
+    return *m_drawFramebuffer;
+}
+
+void GlState::setViewport(const glm::ivec4& viewport)
+{
+    if (change(m_viewport != viewport))
+    {
+        glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+        m_viewport = viewport;
+    }
+}
+
+void GlState::setViewport(int x, int y, int width, int height)
+{
+    setViewport(glm::ivec4(x, y, width, height));
+}
+
+glm::ivec4 GlState::getViewport()
+{
+    if (!m_viewport)
+    {
+        glm::ivec4 viewport;
+        glGetIntegerv(GL_VIEWPORT, &viewport.x);
+        m_viewport = viewport;
+    }
+    return *m_viewport;
+}
+
+void GlState::setDepthFunc(GLenum func)
+{
+    if (change(m_depthFunc != func))
+    {
+        glDepthFunc(func);
+        m_depthFunc = func;
+    }
+}
+
+void GlState::setDepthMask(bool enabled)
+{
+    if (change(m_depthMask != enabled))
+    {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+        m_depthMask = enabled;
+    }
+}
+
+void GlState::setColorMask(const glm::bvec4& mask)
+{
+    if (change(m_colorMask != mask))
+    {
+        glColorMask(mask.r ? GL_TRUE : GL_FALSE, mask.g ? GL_TRUE : GL_FALSE, mask.b ? GL_TRUE : GL_FALSE, mask.a ? GL_TRUE : GL_FALSE);
+        m_colorMask = mask;
+    }
+}
+
+GLenum GlState::getDepthFunc()
+{
+    if (!m_depthFunc)
+    {
+        GLint func;
+        glGetIntegerv(GL_DEPTH_FUNC, &func);
+        m_depthFunc = static_cast<GLenum>(func);
+    }
+    return *m_depthFunc;
+}
+
+bool GlState::getDepthMask()
+{
+    if (!m_depthMask)
+    {
+        GLboolean enabled;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &enabled);
+        m_depthMask = enabled == GL_TRUE;
+    }
+    return *m_depthMask;
+}
+
+glm::bvec4 GlState::getColorMask()
+{
+    if (!m_colorMask)
+    {
+        GLboolean mask[4];
+        glGetBooleanv(GL_COLOR_WRITEMASK, mask);
+        m_colorMask = glm::bvec4(mask[0] == GL_TRUE, mask[1] == GL_TRUE, mask[2] == GL_TRUE, mask[3] == GL_TRUE);
+    }
+    return *m_colorMask;
+}
+
+void GlState::invalidate()
+{
+    m_program.reset();
+    m_vertexArray.reset();
+    m_drawFramebuffer.reset();
+    m_readFramebuffer.reset();
+    m_buffers.clear();
+    m_bufferRanges.clear();
+    m_viewport.reset();
+    m_depthFunc.reset();
+    m_depthMask.reset();
+    m_colorMask.reset();
+}
+
+void GlState::forgetProgram(GLuint program)
+{
+    // a deleted program stays in use until another one is installed, but its name may be reused
+    if (m_program == program)
+        m_program.reset();
+}
+
+void GlState::forgetVertexArray(GLuint vertexArray)
+{
+    if (m_vertexArray == vertexArray)
+        m_vertexArray = 0;
+}
+
+void GlState::forgetFramebuffer(GLuint framebuffer)
+{
+    if (m_drawFramebuffer == framebuffer)
+        m_drawFramebuffer = 0;
+    if (m_readFramebuffer == framebuffer)
+        m_readFramebuffer = 0;
+}
+
+void GlState::forgetBuffer(GLuint buffer)
+{
+    for (auto& [target, current] : m_buffers)
+    {
+        if (current == buffer)
+            current = 0;
+    }
+    for (auto& [binding, range] : m_bufferRanges)
+    {
+        if (range.buffer == buffer)
+            range = { 0, 0, 0 };
+    }
+}
+
+const GlStateStatistics& GlState::getStatistics() const
+{
+    return m_statistics;
+}
+
+void GlState::resetStatistics()
+{
+    m_statistics = GlStateStatistics();
+}
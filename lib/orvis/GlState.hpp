@@ -0,0 +1,102 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+using namespace gl;
+
+/** @brief The number of state changes that went through GlState since the last GlState::resetStatistics. */
+struct GlStateStatistics
+{
+    size_t issued = 0;  //!< Calls that changed the state and were passed to OpenGL.
+    size_t skipped = 0; //!< Calls that would have set the state that was already current.
+};
+
+/**
+ * @brief Shadows the bindings, the viewport and the depth and color masks of the current context and filters redundant
+ * state changes.
+ * @details Buffer::bind, RingBuffer::bind, Program::use, VertexArray::bind, FrameBuffer::bind and all viewport, depth
+ * function, depth mask and color mask changes go through the tracker of the current thread. Since a thread has at most one current context, there is one tracker
+ * per thread. Deleting an object through the OpenGL_RAII deleters removes it from the shadowed state, so recycled
+ * names are bound again. Code that changes the tracked state without GlState has to call GlState::invalidate.
+ */
+class GlState
+{
+public:
+    /** @return The state tracker of the context that is current on the calling thread. */
+    static GlState& get();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+
+    /** @brief Binds a framebuffer, GL_FRAMEBUFFER sets both the draw and the read framebuffer. */
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+
+    /** @return The bound draw framebuffer. Only queries OpenGL if it was never set through GlState. */
+    GLuint getDrawFramebuffer();
+
+    /** @brief Binds a buffer to a non-indexed target, e.g. GL_DRAW_INDIRECT_BUFFER. */
+    void bindBuffer(GLenum target, GLuint buffer);
+
+    /** @brief Binds a buffer range to an indexed target. Like glBindBufferRange, also sets the generic binding of the target. */
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    void setViewport(const glm::ivec4& viewport);
+    void setViewport(int x, int y, int width, int height);
+
+    /** @return The current viewport (x, y, width, height). Only queries OpenGL if it was never set through GlState. */
+    glm::ivec4 getViewport();
+
+    void setDepthFunc(GLenum func);
+    void setDepthMask(bool enabled);
+    void setColorMask(const glm::bvec4& mask);
+
+    /** @return The current depth function. Only queries OpenGL if it was never set through GlState. */
+    GLenum getDepthFunc();
+
+    /** @return true if depth writes are enabled. Only queries OpenGL if it was never set through GlState. */
+    bool getDepthMask();
+
+    /** @return The current color write mask (r, g, b, a). Only queries OpenGL if it was never set through GlState. */
+    glm::bvec4 getColorMask();
+
+    /** @brief Forgets all shadowed state, e.g. after code that binds objects directly. The next calls are all issued. */
+    void invalidate();
+
+    /** @brief Removes a deleted object from the shadowed state, OpenGL unbinds deleted objects from the current context. */
+    void forgetProgram(GLuint program);
+    void forgetVertexArray(GLuint vertexArray);
+    void forgetFramebuffer(GLuint framebuffer);
+    void forgetBuffer(GLuint buffer);
+
+    /** @brief The counters of this thread, GlProfiler::newFrame reads and resets them once per frame. */
+    const GlStateStatistics& getStatistics() const;
+    void resetStatistics();
+
+private:
+    struct BufferRange
+    {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    /** @return true if the call has to be issued, counts the call either way. */
+    bool change(bool changed);
+
+    std::optional<GLuint> m_program;
+    std::optional<GLuint> m_vertexArray;
+    std::optional<GLuint> m_drawFramebuffer;
+    std::optional<GLuint> m_readFramebuffer;
+    std::unordered_map<GLenum, GLuint> m_buffers;
+    std::map<std::pair<GLenum, GLuint>, BufferRange> m_bufferRanges;
+    std::optional<glm::ivec4> m_viewport;
+    std::optional<GLenum> m_depthFunc;
+    std::optional<bool> m_depthMask;
+    std::optional<glm::bvec4> m_colorMask;
+
+    GlStateStatistics m_statistics;
+};
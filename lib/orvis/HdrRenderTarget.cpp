@@ -0,0 +1,193 @@
+#include "HdrRenderTarget.hpp"
+#include "GlState.hpp"
+#include "GlProfiler.hpp"
+#include <array>
+#include <imgui.h>
+
+namespace
+{
+    glm::ivec2 getBloomSize(glm::ivec2 size)
+    {
+        return glm::max((size + 1) / 2, glm::ivec2(1));
+    }
+}
+
+HdrRenderTarget::HdrRenderTarget(glm::ivec2 size, GLenum format, PostProcessingEffects effects)
+    : m_hdrFBO(size),
+      m_hdrTexture(std::make_shared<Texture>(GL_TEXTURE_2D, format, size, 1)),
+      m_ldrTexture(std::make_shared<Texture>(GL_TEXTURE_2D, GL_RGBA8, size, 1)),
+      m_bloomTexture(std::make_shared<Texture>(GL_TEXTURE_2D, GL_R11F_G11F_B10F, getBloomSize(size), bloomLevels)),
+      m_parameterBuffer(4)
+{
+    static_assert(bloomLevels >= 1 && bloomLevels <= 5, "bloomDownsample.comp reduces a 16x16 tile, so at most 5 levels fit");
+
+    m_hdrFBO.addColorAttachment(0, m_hdrTexture);
+    m_hdrFBO.updateDrawBuffers();
+    m_ldrFBO.addColorAttachment(0, m_ldrTexture);
+    m_ldrFBO.updateDrawBuffers();
+
+    m_bloomTexture->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    m_bloomTexture->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    std::vector<glsp::definition> bloomDefinitions = binding::defaultShaderDefines;
+    bloomDefinitions.emplace_back("BLOOM_LEVELS", bloomLevels);
+    m_bloomProgram.attach(std::make_shared<Shader>(GL_COMPUTE_SHADER, ShaderFile::load("compute/bloomDownsample.comp"), bloomDefinitions));
+
+    setEffects(effects);
+}
+
+void HdrRenderTarget::resize(glm::ivec2 size)
+{
+    m_hdrFBO.resize(size);
+    m_ldrFBO.resize(size);
+    m_bloomTexture->resize(GL_TEXTURE_2D, GL_R11F_G11F_B10F, getBloomSize(size), bloomLevels);
+}
+
+void HdrRenderTarget::bind() const
+{
+    m_hdrFBO.bind();
+    const glm::ivec2 renderSize = getRenderSize();
+    GlState::get().setViewport(0, 0, renderSize.x, renderSize.y);
+}
+
+void HdrRenderTarget::setRenderScale(float scale)
+{
+    m_renderScale = glm::clamp(scale, 0.25f, 1.0f);
+}
+
+float HdrRenderTarget::getRenderScale() const
+{
+    return m_renderScale;
+}
+
+glm::ivec2 HdrRenderTarget::getRenderSize() const
+{
+    return glm::max(glm::ivec2(glm::vec2(m_hdrFBO.getSize()) * m_renderScale), glm::ivec2(1));
+}
+
+void HdrRenderTarget::setEffects(const PostProcessingEffects& effects)
+{
+    m_effects = effects;
+
+    std::vector<glsp::definition> definitions = binding::defaultShaderDefines;
+    definitions.emplace_back("BLOOM_LEVELS", bloomLevels);
+    if (effects.bloom)
+        definitions.emplace_back("BLOOM");
+    if (effects.colorGrading)
+        definitions.emplace_back("COLOR_GRADING");
+    if (effects.vignette)
+        definitions.emplace_back("VIGNETTE");
+    if (effects.fxaa)
+        definitions.emplace_back("FXAA");
+    if (effects.dithering)
+        definitions.emplace_back("DITHERING");
+
+    m_resolveProgram = Program();
+    m_resolveProgram.attach(std::make_shared<Shader>(GL_COMPUTE_SHADER, ShaderFile::load("compute/postProcessing.comp"), definitions));
+}
+
+const PostProcessingEffects& HdrRenderTarget::getEffects() const
+{
+    return m_effects;
+}
+
+void HdrRenderTarget::setParameters(const PostProcessingParameters& parameters)
+{
+    m_parameters = parameters;
+}
+
+const PostProcessingParameters& HdrRenderTarget::getParameters() const
+{
+    return m_parameters;
+}
+
+void HdrRenderTarget::clear() const
+{
+    constexpr std::array<float, 4> black = { 0.0f, 0.0f, 0.0f, 0.0f };
+    constexpr float farDepth = 1.0f;
+    glClearNamedFramebufferfv(*m_hdrFBO.id(), GL_COLOR, 0, black.data());
+    glClearNamedFramebufferfv(*m_hdrFBO.id(), GL_DEPTH, 0, &farDepth);
+}
+
+void HdrRenderTarget::resolve(const std::shared_ptr<Camera>& camera) const
+{
+    GlProfiler::Scope profilerScope("HdrRenderTarget::resolve");
+    const glm::ivec2 size = m_hdrFBO.getSize();
+
+    FrameBuffer::unbind();
+    GlState::get().setViewport(0, 0, size.x, size.y);
+    camera->uploadToGpu();
+
+    // the shaders need the exact fraction of the texture that is covered by the viewport
+    const glm::vec2 renderScale = glm::vec2(getRenderSize()) / glm::vec2(size);
+    m_parameterBuffer.push(GpuPostProcessing{ renderScale, m_parameters.bloomIntensity, m_parameters.bloomThreshold,
+        m_parameters.vignetteStrength, m_parameters.saturation, m_parameters.contrast, 0.0f });
+    m_parameterBuffer.bind(GL_UNIFORM_BUFFER, BufferBinding::postProcessing);
+
+    m_hdrTexture->bind(TextureBinding::screenColor);
+
+    if (m_effects.bloom)
+    {
+        for (int level = 0; level < bloomLevels; ++level)
+            m_bloomTexture->bindImage(static_cast<GLuint>(ImageBinding::bloom) + level, level, false, 0, GL_WRITE_ONLY, GL_R11F_G11F_B10F);
+
+        const glm::ivec2 bloomSize = getBloomSize(getRenderSize());
+        m_bloomProgram.use();
+        glDispatchCompute((bloomSize.x + 15) / 16, (bloomSize.y + 15) / 16, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        m_bloomTexture->bind(TextureBinding::bloom);
+    }
+
+    m_ldrTexture->bindImage(ImageBinding::screenColor, GL_WRITE_ONLY, GL_RGBA8);
+    m_resolveProgram.use();
+    glDispatchCompute((size.x + 15) / 16, (size.y + 15) / 16, 1);
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+
+    m_ldrFBO.blitToDefault();
+}
+
+const FrameBuffer& HdrRenderTarget::getFrameBuffer() const
+{
+    return m_hdrFBO;
+}
+
+bool HdrRenderTarget::drawGuiWindow()
+{
+    ImGui::SetNextWindowSize(ImVec2(300, 100), ImGuiSetCond_FirstUseEver);
+    ImGui::Begin("Post Processing");
+    const bool changed = drawGuiContent();
+    ImGui::End();
+    return changed;
+}
+
+bool HdrRenderTarget::drawGuiContent()
+{
+    ImGui::PushID(this);
+
+    PostProcessingEffects effects = m_effects;
+    bool effectsChanged = ImGui::Checkbox("Bloom", &effects.bloom);
+    effectsChanged |= ImGui::Checkbox("Color grading", &effects.colorGrading);
+    effectsChanged |= ImGui::Checkbox("Vignette", &effects.vignette);
+    effectsChanged |= ImGui::Checkbox("FXAA", &effects.fxaa);
+    effectsChanged |= ImGui::Checkbox("Dithering", &effects.dithering);
+    if (effectsChanged)
+        setEffects(effects);
+
+    bool changed = effectsChanged;
+    if (m_effects.bloom)
+    {
+        changed |= ImGui::SliderFloat("Bloom intensity", &m_parameters.bloomIntensity, 0.0f, 1.0f);
+        changed |= ImGui::SliderFloat("Bloom threshold", &m_parameters.bloomThreshold, 0.0f, 10.0f);
+    }
+    if (m_effects.vignette)
+        changed |= ImGui::SliderFloat("Vignette", &m_parameters.vignetteStrength, 0.0f, 1.0f);
+    if (m_effects.colorGrading)
+    {
+        changed |= ImGui::SliderFloat("Saturation", &m_parameters.saturation, 0.0f, 2.0f);
+        changed |= ImGui::SliderFloat("Contrast", &m_parameters.contrast, 0.5f, 2.0f);
+    }
+
+    ImGui::PopID();
+    return changed;
+}
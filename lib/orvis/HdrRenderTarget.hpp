@@ -0,0 +1,127 @@
+#pragma once
+
+#include <glbinding/gl/gl.h>
+#include "Camera.hpp"
+#include "Buffer.hpp"
+#include "RingBuffer.hpp"
+#include "FrameBuffer.hpp"
+#include "Shader.hpp"
+#include "Texture.hpp"
+
+using namespace gl;
+
+/** @brief The post processing effects of HdrRenderTarget::resolve, every combination is compiled into one shader. */
+struct PostProcessingEffects
+{
+    bool bloom = true;          //!< Adds a blurred version of the pixels above the bloom threshold.
+    bool colorGrading = false;  //!< Applies saturation and contrast after tone mapping.
+    bool vignette = true;       //!< Darkens the image towards the borders.
+    bool fxaa = true;           //!< Fast approximate anti-aliasing on the tone mapped image.
+    bool dithering = true;      //!< Adds noise of one quantization step to prevent banding.
+};
+
+/** @brief The runtime parameters of the post processing effects. */
+struct PostProcessingParameters
+{
+    float bloomIntensity = 0.2f;
+    float bloomThreshold = 1.0f;    //!< HDR luminance (before exposure) above which pixels bloom.
+    float vignetteStrength = 0.4f;
+    float saturation = 1.0f;
+    float contrast = 1.0f;
+};
+
+/**
+ * @brief Floating point render target for the scene. All shaders output linear radiance,
+ * tone mapping, gamma correction and the other post processing effects are applied by HdrRenderTarget::resolve.
+ * @details All per pixel effects are fused into a single compute dispatch, FXAA works on a shared memory tile of the
+ * tone mapped image. Bloom needs one additional dispatch that builds the whole downsample pyramid at once.
+ * The scene can be rendered at a lower resolution (see HdrRenderTarget::setRenderScale), the resolve then upscales
+ * it to the full size with a bicubic filter.
+ */
+class HdrRenderTarget
+{
+public:
+    /**
+     * @brief Creates the HDR framebuffer (color and depth) and the 8 bit resolve target.
+     * @param size The size of the render target (usually the window size).
+     * @param format The color format, GL_R11F_G11F_B10F or GL_RGBA16F.
+     * @param effects The post processing effects applied by the resolve.
+     */
+    explicit HdrRenderTarget(glm::ivec2 size, GLenum format = GL_R11F_G11F_B10F, PostProcessingEffects effects = {});
+
+    /** @brief Resizes all render targets. */
+    void resize(glm::ivec2 size);
+
+    /** @brief Binds the HDR framebuffer for rendering and sets the viewport to the render size. */
+    void bind() const;
+
+    /**
+     * @brief Sets the fraction of the full size per axis that is rendered, e.g. from DynamicResolution.
+     * @details The framebuffer keeps its size, only the viewport shrinks, so changing the scale every frame is cheap.
+     * @param scale The render scale, clamped to [0.25, 1].
+     */
+    void setRenderScale(float scale);
+    float getRenderScale() const;
+
+    /** @return The size of the rendered region, i.e. the full size times the render scale. */
+    glm::ivec2 getRenderSize() const;
+
+    /** @brief Selects the post processing effects, recompiles the resolve shader. */
+    void setEffects(const PostProcessingEffects& effects);
+    const PostProcessingEffects& getEffects() const;
+
+    void setParameters(const PostProcessingParameters& parameters);
+    const PostProcessingParameters& getParameters() const;
+
+    /** @brief Clears color and depth of the HDR framebuffer. */
+    void clear() const;
+
+    /**
+     * @brief Tone maps the HDR image with the exposure and gamma of the given camera, applies the post processing
+     * effects and copies the result to the default framebuffer. Leaves the default framebuffer bound.
+     */
+    void resolve(const std::shared_ptr<Camera>& camera) const;
+
+    /** @return The HDR framebuffer. */
+    const FrameBuffer& getFrameBuffer() const;
+
+    /**
+    * @brief Draws a ImGui-window containing the post processing effects and parameters.
+    * @return true if the parameters were changed.
+    */
+    bool drawGuiWindow();
+
+    /**
+    * @brief Draws the ImGui-content containing the post processing effects and parameters.
+    * @return true if the parameters were changed.
+    */
+    bool drawGuiContent();
+
+    /** @brief The number of bloom pyramid levels, limited by the 16x16 tile that one workgroup reduces. */
+    static constexpr int bloomLevels = 5;
+
+private:
+    // mirrors the PostProcessingBuffer in postProcessing.glsl (std140)
+    struct GpuPostProcessing
+    {
+        glm::vec2 renderScale;
+        float bloomIntensity;
+        float bloomThreshold;
+        float vignetteStrength;
+        float saturation;
+        float contrast;
+        float padding;
+    };
+
+    FrameBuffer m_hdrFBO;
+    FrameBuffer m_ldrFBO;
+    std::shared_ptr<Texture> m_hdrTexture;
+    std::shared_ptr<Texture> m_ldrTexture;
+    std::shared_ptr<Texture> m_bloomTexture;
+    Program m_resolveProgram;
+    Program m_bloomProgram;
+    PostProcessingEffects m_effects;
+    PostProcessingParameters m_parameters;
+    float m_renderScale = 1.0f;
+    mutable RingBuffer<GpuPostProcessing> m_parameterBuffer;
+};
@@ -1,8 +1,12 @@
 #include "Light.hpp"
+#include "GlState.hpp"
+#include "GlProfiler.hpp"
 #include "Bounds.hpp"
 #include <imgui.h>
 #include <functional>
 
+static_assert(sizeof(Light) == 160, "Light has to match the std430 layout of the struct in light.glsl");
+
 Light::Light(const Light& other)
 {
     color = other.color;
@@ -13,6 +17,10 @@ Light::Light(const Light& other)
     m_type = other.m_type;
     m_lightSpaceMatrix = other.m_lightSpaceMatrix;
     m_shadowMapHandle = other.m_shadowMapHandle;
+    m_momentMapHandle = other.m_momentMapHandle;
+    m_shadowFilter = other.m_shadowFilter;
+    m_lightBleedingReduction = other.m_lightBleedingReduction;
+    m_minMaxMapHandle = other.m_minMaxMapHandle;
 }
 
 Light& Light::operator=(const Light& other)
@@ -25,6 +33,10 @@ Light& Light::operator=(const Light& other)
     m_type = other.m_type;
     m_lightSpaceMatrix = other.m_lightSpaceMatrix;
     m_shadowMapHandle = other.m_shadowMapHandle;
+    m_momentMapHandle = other.m_momentMapHandle;
+    m_shadowFilter = other.m_shadowFilter;
+    m_lightBleedingReduction = other.m_lightBleedingReduction;
+    m_minMaxMapHandle = other.m_minMaxMapHandle;
     return *this;
 }
 
@@ -46,6 +58,22 @@ std::shared_ptr<Light> Light::makeSpotLight(glm::vec3 position, glm::vec3 direct
 void Light::updateShadowMap(const Scene& scene) const
 {
     m_shadowMap->render(scene, m_lightSpaceMatrix);
+
+    // each filter only reads its own derived data, switching the filter needs a shadow map update
+    if (m_shadowFilter == ShadowFilter::evsm && m_shadowMap->momentTexture)
+        m_shadowMap->generateMoments();
+    else if (m_shadowFilter == ShadowFilter::pcf && m_shadowMap->minMaxTexture)
+        m_shadowMap->generateMinMaxPyramid();
+}
+
+void Light::setShadowFilter(ShadowFilter filter)
+{
+    m_shadowFilter = filter;
+}
+
+ShadowFilter Light::getShadowFilter() const
+{
+    return m_shadowFilter;
 }
 
 void Light::recalculateLightSpaceMatrix(const Scene& scene)
@@ -81,9 +109,9 @@ void Light::recalculateLightSpaceMatrix(const Scene& scene)
     }
     else if (m_type == LightType::point)
     {
-        // TODO is cutoff supposed to be used here? or 90 degrees (cube)?
-        projection = glm::perspective(glm::radians(90.0f), static_cast<float>(m_shadowMap->shadowFBO.getDepthTexture()->getSize().x) / static_cast<float>(m_shadowMap->shadowFBO.getDepthTexture()->getSize().y), 0.1f, bboxSize);
-        view = glm::mat4(1.0f); // calculate finished matrix in shader
+        // 90 degrees per cube face, the six face view matrices are derived from the light position in the shaders
+        projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, bboxSize);
+        view = glm::mat4(1.0f);
     }
 
     m_lightSpaceMatrix = projection * view;
@@ -92,46 +120,146 @@ void Light::recalculateLightSpaceMatrix(const Scene& scene)
 Light::Light(glm::vec3 position, glm::vec3 direction, glm::vec3 color, float cutOff, LightType type) :
     color(color), cutOff(cutOff), position(position), direction(direction), m_type(type)
 {
-    m_shadowMap = std::make_unique<ShadowMap>();
+    m_shadowMap = std::make_unique<ShadowMap>(type);
     m_shadowMap->shadowFBO.getDepthTexture()->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     m_shadowMap->shadowFBO.getDepthTexture()->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     m_shadowMap->shadowFBO.getDepthTexture()->set(GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
     m_shadowMap->shadowFBO.getDepthTexture()->set(GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
     m_shadowMapHandle = m_shadowMap->shadowFBO.getDepthTexture()->handle();
+
+    if (m_shadowMap->momentTexture)
+    {
+        m_shadowMap->momentTexture->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        m_shadowMap->momentTexture->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        m_momentMapHandle = m_shadowMap->momentTexture->handle();
+    }
+
+    if (m_shadowMap->minMaxTexture)
+        m_minMaxMapHandle = m_shadowMap->minMaxTexture->handle();
 }
 
-Light::ShadowMap::ShadowMap()
+Light::ShadowMap::ShadowMap(LightType type) : type(type)
 {
-    shadowProgram.attachNew(GL_VERTEX_SHADER, ShaderFile::load("vertex/lightTransform.vert"));
+    const GLenum target = type == LightType::point ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    // no mipmaps, compare sampling can not use them (the min/max pyramid takes their place)
+    shadowFBO.setDepthAttachment(std::make_shared<Texture>(target, GL_DEPTH_COMPONENT32F, glm::ivec2(1024, 1024), 1));
+
+    std::vector<glsp::definition> definitions = binding::defaultShaderDefines;
+    if (type == LightType::point)
+        definitions.emplace_back("CUBE_SHADOW_MAP");
+
+    shadowProgram.attach(std::make_shared<Shader>(GL_VERTEX_SHADER, ShaderFile::load("vertex/lightTransform.vert"), definitions));
     shadowProgram.attachNew(GL_FRAGMENT_SHADER, ShaderFile::load("fragment/shadowMap.frag"));
+
+    // no fragment shader needed without alpha test
+    definitions.emplace_back("DEPTH_ONLY");
+    depthProgram.attach(std::make_shared<Shader>(GL_VERTEX_SHADER, ShaderFile::load("vertex/lightTransform.vert"), definitions));
+
+    if (type != LightType::point)
+    {
+        const glm::ivec2 size = glm::ivec2(shadowFBO.getDepthTexture()->getSize());
+        momentTexture = std::make_shared<Texture>(GL_TEXTURE_2D, GL_RGBA32F, size);
+        blurTexture = std::make_shared<Texture>(GL_TEXTURE_2D, GL_RGBA32F, size, 1);
+
+        std::vector<glsp::definition> conversionDefinitions = binding::defaultShaderDefines;
+        conversionDefinitions.emplace_back("EVSM_CONVERT");
+        momentConversionProgram.attach(std::make_shared<Shader>(GL_COMPUTE_SHADER, ShaderFile::load("compute/evsmBlur.comp"), conversionDefinitions));
+        momentBlurProgram.attachNew(GL_COMPUTE_SHADER, ShaderFile::load("compute/evsmBlur.comp"));
+
+        minMaxTexture = std::make_shared<Texture>(GL_TEXTURE_2D, GL_RG32F, size);
+
+        std::vector<glsp::definition> minMaxDefinitions = binding::defaultShaderDefines;
+        minMaxDefinitions.emplace_back("MIN_MAX_CONVERT");
+        minMaxConversionProgram.attach(std::make_shared<Shader>(GL_COMPUTE_SHADER, ShaderFile::load("compute/minMaxPyramid.comp"), minMaxDefinitions));
+        minMaxReductionProgram.attachNew(GL_COMPUTE_SHADER, ShaderFile::load("compute/minMaxPyramid.comp"));
+    }
 }
 
 void Light::ShadowMap::render(const Scene& scene, const glm::mat4& lightSpaceMatrix) const
 {
+    GlProfiler::Scope profilerScope("Light::ShadowMap::render");
     // store old viewport
-    GLint viewport[4];
-    glGetIntegerv(GL_VIEWPORT, viewport);
+    const glm::ivec4 viewport = GlState::get().getViewport();
 
     shadowFBO.bind();
 
     // set SM render settings
-    glViewport(0, 0, shadowFBO.getDepthTexture()->getSize().x, shadowFBO.getDepthTexture()->getSize().y);
+    GlState::get().setViewport(0, 0, shadowFBO.getDepthTexture()->getSize().x, shadowFBO.getDepthTexture()->getSize().y);
     glClear(GL_DEPTH_BUFFER_BIT);
     glCullFace(GL_FRONT);
 
     // render SM
     //shadowProgram.use();
-    scene.getCamera()->uploadToGpu(glm::mat4(1.0f), lightSpaceMatrix);
-    scene.render(shadowProgram, false);
-
-    shadowFBO.getDepthTexture()->generateMipmaps();
+    if (type == LightType::point)
+    {
+        // all six faces in one pass, culling and the vertex shader read the light directly
+        scene.renderDepth(depthProgram, shadowProgram, false, CullingMode::cubeMap);
+    }
+    else
+    {
+        scene.getCamera()->uploadToGpu(glm::mat4(1.0f), lightSpaceMatrix);
+        scene.renderDepth(depthProgram, shadowProgram, false);
+    }
 
     // restore previous render settings
     FrameBuffer::unbind();
-    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    GlState::get().setViewport(viewport);
     glCullFace(GL_BACK);
 }
 
+void Light::ShadowMap::generateMoments() const
+{
+    const glm::ivec2 size = glm::ivec2(momentTexture->getSize());
+    const glm::uvec2 groups = (glm::uvec2(size) + 15u) / 16u;
+
+    // horizontal pass: convert the raw depth to moments
+    bindDepthForCompute();
+    blurTexture->bindImage(ImageBinding::filterOutput, GL_WRITE_ONLY, GL_RGBA32F);
+    momentConversionProgram.use();
+    glDispatchCompute(groups.x, groups.y, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    // vertical pass
+    blurTexture->bindImage(ImageBinding::filterInput, GL_READ_ONLY, GL_RGBA32F);
+    momentTexture->bindImage(ImageBinding::filterOutput, GL_WRITE_ONLY, GL_RGBA32F);
+    momentBlurProgram.use();
+    glDispatchCompute(groups.x, groups.y, 1);
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    momentTexture->generateMipmaps();
+}
+
+void Light::ShadowMap::generateMinMaxPyramid() const
+{
+    const glm::ivec2 size = glm::ivec2(minMaxTexture->getSize());
+
+    bindDepthForCompute();
+    minMaxTexture->bindImage(ImageBinding::filterOutput, 0, false, 0, GL_WRITE_ONLY, GL_RG32F);
+    minMaxConversionProgram.use();
+    glDispatchCompute((size.x + 15) / 16, (size.y + 15) / 16, 1);
+
+    minMaxReductionProgram.use();
+    for (int level = 1; level < minMaxTexture->getLevels(); ++level)
+    {
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        const glm::ivec2 levelSize = glm::max(size >> level, glm::ivec2(1));
+        minMaxTexture->bindImage(ImageBinding::filterInput, level - 1, false, 0, GL_READ_ONLY, GL_RG32F);
+        minMaxTexture->bindImage(ImageBinding::filterOutput, level, false, 0, GL_WRITE_ONLY, GL_RG32F);
+        glDispatchCompute((levelSize.x + 15) / 16, (levelSize.y + 15) / 16, 1);
+    }
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void Light::ShadowMap::bindDepthForCompute() const
+{
+    // the texture's own sampler compares against a reference, compute passes need the stored depth
+    const auto depthUnit = static_cast<GLuint>(TextureBinding::shadowDepth);
+    glBindTextureUnit(depthUnit, *shadowFBO.getDepthTexture()->id());
+    glBindSampler(depthUnit, 0);
+}
+
 bool Light::drawGuiWindow()
 {
     ImGui::SetNextWindowSize(ImVec2(300, 100), ImGuiSetCond_FirstUseEver);
@@ -180,7 +308,20 @@ bool Light::drawGuiContent()
         if (m_type == LightType::spot)
             changed |= ImGui::SliderFloat("Cutoff", &cutOff, 0.1f, 1.0f);
 
-        changed |= ImGui::SliderInt("PCF size", &pcfKernelSize, 0, 10);
+        if (m_type != LightType::point)
+        {
+            int filter = static_cast<int>(m_shadowFilter);
+            if (ImGui::Combo("Shadow filter", &filter, "PCF\0EVSM\0"))
+            {
+                m_shadowFilter = static_cast<ShadowFilter>(filter);
+                changed = true;
+            }
+
+            if (m_shadowFilter == ShadowFilter::evsm)
+                changed |= ImGui::SliderFloat("Light bleeding reduction", &m_lightBleedingReduction, 0.0f, 0.99f);
+        }
+
+        changed |= ImGui::SliderInt(m_shadowFilter == ShadowFilter::evsm ? "Blur size" : "PCF size", &pcfKernelSize, 0, binding::maxPcfKernelSize);
     }
 
     ImGui::PopID();
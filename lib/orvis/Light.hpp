@@ -16,6 +16,15 @@ enum class LightType : int
     spot = 2
 };
 
+/** @brief Filtering technique used when looking up the shadow map of a light. */
+enum class ShadowFilter : int
+{
+    /** @brief Gaussian percentage-closer filtering with pcfKernelSize taps per direction. */
+    pcf = 0,
+    /** @brief Exponential variance shadow maps, prefiltered once per shadow map update. Point lights fall back to PCF. */
+    evsm = 1
+};
+
 /**
  * @brief Struct containing lighting information passed to the shader.
  * Currently only point lights!
@@ -82,6 +91,12 @@ public:
     */
     bool drawGuiContent();
 
+    /** @brief Sets the filtering technique for the shadow map. Call Scene::updateLightBuffer() and Scene::updateShadowMaps() afterwards. */
+    void setShadowFilter(ShadowFilter filter);
+
+    /** @return The filtering technique for the shadow map. */
+    ShadowFilter getShadowFilter() const;
+
     glm::vec3 color = glm::vec3(1.0f);                                      // all
     float cutOff = glm::radians(25.0f);                                     // spot
     glm::vec3 position = glm::vec3(0.0f, 1.0f, 0.0f);                       // spot, point    
@@ -91,13 +106,35 @@ public:
 private:
     struct ShadowMap
     {
-        ShadowMap();
+        /** @brief Point lights get a cube map that is rendered in a single layered pass, all other lights a 2D shadow map. */
+        explicit ShadowMap(LightType type);
 
         void render(const Scene& scene, const glm::mat4& lightSpaceMatrix) const;
 
-        //Texture shadowTexture{ GL_TEXTURE_2D, GL_DEPTH_COMPONENT32F,  };
-        FrameBuffer shadowFBO{ glm::ivec2(1024, 1024) };
-        Program shadowProgram;
+        /** @brief Converts the depth map to EVSM moments and blurs them separably. Expects the light index buffer to be bound. */
+        void generateMoments() const;
+
+        /** @brief Builds the min/max depth pyramid used by PCF to skip filtering outside of penumbrae. */
+        void generateMinMaxPyramid() const;
+
+        /** @brief Binds the depth map for raw (non-comparing) texel fetches in compute shaders. */
+        void bindDepthForCompute() const;
+
+        LightType type;
+        FrameBuffer shadowFBO;
+        Program depthProgram;   // opaque meshes, position-only
+        Program shadowProgram;  // alpha-tested meshes
+
+        // EVSM (not used for point lights)
+        std::shared_ptr<Texture> momentTexture;
+        std::shared_ptr<Texture> blurTexture;
+        Program momentConversionProgram;
+        Program momentBlurProgram;
+
+        // min/max depth pyramid (not used for point lights)
+        std::shared_ptr<Texture> minMaxTexture;
+        Program minMaxConversionProgram;
+        Program minMaxReductionProgram;
     };
 
     Light(glm::vec3 position, glm::vec3 direction, glm::vec3 color, float cutOff, LightType type);
@@ -110,4 +147,11 @@ private:
     glm::mat4 m_lightSpaceMatrix = glm::mat4(1.0f);
     GLuint64 m_shadowMapHandle = 0; // can be sampler2DShadow or samplerCubeShadow
     std::unique_ptr<ShadowMap> m_shadowMap; // works as padding in glsl (is 64bit)
+
+    GLuint64 m_momentMapHandle = 0; // sampler2D
+    ShadowFilter m_shadowFilter = ShadowFilter::pcf;
+    float m_lightBleedingReduction = 0.1f;
+
+    GLuint64 m_minMaxMapHandle = 0; // sampler2D
+    glm::vec2 m_padding = glm::vec2(0.0f);
 };
@@ -1,6 +1,7 @@
 #include "Material.hpp"
 #include "Util.hpp"
 #include <imgui.h>
+#include <string_view>
 
 Material::Material(glm::vec4 color, float roughness, float metallic, float ior)
 {
@@ -114,6 +115,55 @@ void Material::setIOR(float ior)
     m_ior = glm::max(0.0f, ior);
 }
 
+GLuint Material::getTextureBitset() const
+{
+    return m_isTextureBitset;
+}
+
+bool Material::replaceHandle(GLuint64 oldHandle, GLuint64 newHandle)
+{
+    bool replaced = false;
+    const auto replace = [&](glm::uvec2& handle, MaterialTextureBitsetIndex bit)
+    {
+        if (util::getBit(m_isTextureBitset, bit) && glm::packUint2x32(handle) == oldHandle)
+        {
+            handle = glm::unpackUint2x32(newHandle);
+            replaced = true;
+        }
+    };
+    replace(m_albedo, MAT_COLOR_BIT);
+    replace(m_roughness, MAT_ROUGHNESS_BIT);
+    replace(m_metallic, MAT_METALLIC_BIT);
+
+    for (auto [handle, bit] : { std::make_pair(&m_normal, MAT_NORMAL_BIT), std::make_pair(&m_ao, MAT_AO_BIT) })
+    {
+        if (util::getBit(m_isTextureBitset, bit) && *handle == oldHandle)
+        {
+            *handle = newHandle;
+            replaced = true;
+        }
+    }
+    return replaced;
+}
+
+bool Material::operator==(const Material& other) const
+{
+    return m_albedo == other.m_albedo && m_roughness == other.m_roughness && m_metallic == other.m_metallic
+        && m_ior == other.m_ior && m_isTextureBitset == other.m_isTextureBitset && m_normal == other.m_normal && m_ao == other.m_ao;
+}
+
+bool Material::operator!=(const Material& other) const
+{
+    return !(*this == other);
+}
+
+size_t Material::hash() const
+{
+    // the material is exactly what is uploaded to the GPU, so hashing its bytes hashes the content
+    static_assert(sizeof(Material) == 48, "Material must not contain padding bytes");
+    return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(this), sizeof(Material)));
+}
+
 bool Material::drawGuiWindow()
 {
     ImGui::SetNextWindowSize(ImVec2(300, 100), ImGuiSetCond_FirstUseEver);
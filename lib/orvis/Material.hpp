@@ -64,6 +64,25 @@ public:
     void  setIOR(float ior);
     float getIOR() const;
 
+    /**
+     * @return The bitset of all parameters that are textures (see MaterialTextureBitsetIndex).
+     * Materials with the same bitset can be drawn with the same MaterialProgram variant.
+     */
+    GLuint getTextureBitset() const;
+
+    /**
+     * @brief Replaces the bindless handle of a texture that was reallocated, e.g. by TextureStreaming.
+     * @return true if the material referenced the old handle.
+     */
+    bool replaceHandle(GLuint64 oldHandle, GLuint64 newHandle);
+
+    /** @return true if both materials have the same GPU representation (same values and texture handles). */
+    bool operator==(const Material& other) const;
+    bool operator!=(const Material& other) const;
+
+    /** @return A hash of the GPU representation, consistent with operator==. */
+    size_t hash() const;
+
     /**
     * @brief Draws a ImGui-window containing the material parameters.
     * @return true if the parameters were changed.
@@ -89,3 +108,12 @@ private:
     GLuint64 m_ao = 0;
 
 };
+
+namespace std
+{
+    template <>
+    struct hash<Material>
+    {
+        size_t operator()(const Material& material) const { return material.hash(); }
+    };
+}
@@ -0,0 +1,28 @@
+#include "MaterialProgram.hpp"
+
+MaterialProgram::MaterialProgram(const Shader::ShaderSource& vertexShader, const Shader::ShaderSource& fragmentShader,
+    std::vector<glsp::definition> definitions)
+    : m_fragmentShader(fragmentShader),
+      m_vertexShader(std::make_shared<Shader>(GL_VERTEX_SHADER, vertexShader, definitions)),
+      m_definitions(std::move(definitions))
+{
+}
+
+const Program& MaterialProgram::get(GLuint materialFeatures) const
+{
+    const auto [variant, inserted] = m_variants.try_emplace(materialFeatures);
+    if (inserted)
+    {
+        std::vector<glsp::definition> definitions = m_definitions;
+        definitions.emplace_back("MATERIAL_FEATURES", static_cast<int>(materialFeatures));
+
+        variant->second.attach(m_vertexShader);
+        variant->second.attach(std::make_shared<Shader>(GL_FRAGMENT_SHADER, m_fragmentShader, definitions));
+    }
+    return variant->second;
+}
+
+size_t MaterialProgram::variantCount() const
+{
+    return m_variants.size();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <unordered_map>
+#include "Shader.hpp"
+
+/**
+ * @brief A vertex/fragment program that is specialized per material feature set.
+ * @details Every variant is compiled with MATERIAL_FEATURES set to the texture bitset of the materials it draws
+ * (see MaterialTextureBitsetIndex), so getMaterial only contains the texture fetches that the material uses.
+ * Variants are compiled on first use and cached.
+ */
+class MaterialProgram
+{
+public:
+    /**
+     * @param vertexShader The vertex shader source, shared by all variants.
+     * @param fragmentShader The fragment shader source, specialized per variant.
+     * @param definitions Defines that are added to all variants.
+     */
+    MaterialProgram(const Shader::ShaderSource& vertexShader, const Shader::ShaderSource& fragmentShader,
+        std::vector<glsp::definition> definitions = binding::defaultShaderDefines);
+
+    /** @return The program variant for the given material texture bitset, compiles it if necessary. */
+    const Program& get(GLuint materialFeatures) const;
+
+    /** @return The number of variants compiled so far. */
+    size_t variantCount() const;
+
+private:
+    Shader::ShaderSource m_fragmentShader;
+    std::shared_ptr<Shader> m_vertexShader;
+    std::vector<glsp::definition> m_definitions;
+    mutable std::unordered_map<GLuint, Program> m_variants;
+};
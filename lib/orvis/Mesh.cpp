@@ -72,7 +72,11 @@ Mesh::Mesh(aiMesh* assimpMesh, aiMaterial* assimpMat, const std::filesystem::pat
             {
                 m_textures[aiTextureType_DIFFUSE] = std::make_shared<Texture>(absTexPath, 4);
                 material.setColor(m_textures[aiTextureType_DIFFUSE]);
-                m_transparent = m_textures[aiTextureType_DIFFUSE]->data<float>(GL_RGBA)[3] < 0.9f;
+                // depth passes skip the alpha test for opaque meshes, so a single cut out texel makes it transparent
+                const std::vector<uint8_t> pixels = m_textures[aiTextureType_DIFFUSE]->data<uint8_t>(GL_RGBA);
+                m_transparent = false;
+                for (size_t i = 3; i < pixels.size() && !m_transparent; i += 4)
+                    m_transparent = pixels[i] < static_cast<uint8_t>(0.9f * 255.0f);
                 break;
             }
             case aiTextureType_OPACITY: //albedo alpha
@@ -204,6 +208,8 @@ void Mesh::copyToAlpha(const std::filesystem::path& src, const std::shared_ptr<T
 
     stbi_image_free(img);
     dst->generateMipmaps();
+    // the alpha channel does not come from the file anymore
+    dst->setSourceFile({}, 0);
 }
 
 std::shared_ptr<Texture> Mesh::generateNormalFromHeight(const std::filesystem::path& src) const
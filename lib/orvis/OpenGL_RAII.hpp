@@ -2,32 +2,36 @@
 #include <glbinding/gl/gl.h>
 #include <GLFW/glfw3.h>
 #include <memory>
+#include "GlDeletionQueue.hpp"
+#include "GlState.hpp"
 
 using namespace gl;
 
-template<void(*deleterFunc)(GLuint)>
+template<void(*deleterFunc)(GLsizei, const GLuint*)>
 struct GlPtr {	
 	GlPtr(std::nullptr_t = nullptr) : id(0) {}
 	GlPtr(GLuint id) : id(id) {}
 	operator GLuint() const { return id; }
-	friend bool operator == (GlPtr x, GlPtr y) { return x.id == y.id; }
-	friend bool operator != (GlPtr x, GlPtr y) { return x.id != y.id; }
+	// by reference, a destroyed copy would release the object
+	friend bool operator == (const GlPtr& x, const GlPtr& y) { return x.id == y.id; }
+	friend bool operator != (const GlPtr& x, const GlPtr& y) { return x.id != y.id; }
 
-	~GlPtr() { if (glfwGetCurrentContext() != nullptr) deleterFunc(id); }
+	// deleted once the GPU is done with it, may die on any thread (see GlDeletionQueue)
+	~GlPtr() { if (id != 0) GlDeletionQueue::get().enqueue(deleterFunc, id); }
 
 private:
 	GLuint id;
 };
 
-// deleters
-inline void deleteTexture(GLuint id) { if (id != 0) glDeleteTextures(1, &id); }
-inline void deleteSampler(GLuint id) { if (id != 0) glDeleteSamplers(1, &id); }
-inline void deleteShader(GLuint id) { if (glIsShader(id)) glDeleteShader(id); }
-inline void deleteProgram(GLuint id) { if (glIsProgram(id)) glDeleteProgram(id); }
-inline void deleteBuffer(GLuint id) { if (id != 0) glDeleteBuffers(1, &id); }
-inline void deleteFramebuffer(GLuint id) { if (id != 0) glDeleteFramebuffers(1, &id); }
-inline void deleteVertexArray(GLuint id) { if (glIsVertexArray(id)) glDeleteVertexArrays(1, &id); }
-inline void deleteQuery(GLuint id) { if (id != 0) glDeleteQueries(1, &id); }
+// batch deleters, called by GlDeletionQueue on the render thread
+inline void deleteTexture(GLsizei n, const GLuint* ids) { glDeleteTextures(n, ids); }
+inline void deleteSampler(GLsizei n, const GLuint* ids) { glDeleteSamplers(n, ids); }
+inline void deleteShader(GLsizei n, const GLuint* ids) { for (GLsizei i = 0; i < n; ++i) if (glIsShader(ids[i])) glDeleteShader(ids[i]); }
+inline void deleteProgram(GLsizei n, const GLuint* ids) { for (GLsizei i = 0; i < n; ++i) if (glIsProgram(ids[i])) { GlState::get().forgetProgram(ids[i]); glDeleteProgram(ids[i]); } }
+inline void deleteBuffer(GLsizei n, const GLuint* ids) { for (GLsizei i = 0; i < n; ++i) GlState::get().forgetBuffer(ids[i]); glDeleteBuffers(n, ids); }
+inline void deleteFramebuffer(GLsizei n, const GLuint* ids) { for (GLsizei i = 0; i < n; ++i) GlState::get().forgetFramebuffer(ids[i]); glDeleteFramebuffers(n, ids); }
+inline void deleteVertexArray(GLsizei n, const GLuint* ids) { for (GLsizei i = 0; i < n; ++i) GlState::get().forgetVertexArray(ids[i]); glDeleteVertexArrays(n, ids); }
+inline void deleteQuery(GLsizei n, const GLuint* ids) { glDeleteQueries(n, ids); }
 
 // types
 typedef std::shared_ptr<GlPtr<deleteTexture>> GLtexture;
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <glbinding/gl/gl.h>
+#include <vector>
+#include "Buffer.hpp"
+#include "OpenGL_RAII.hpp"
+
+using namespace gl;
+
+/**
+ * @brief Reads buffer contents back to the CPU without waiting for the GPU, e.g. per-frame feedback of a shader.
+ * @details The storage is split into slots that are persistently and coherently mapped for reading. A request copies
+ * the source buffer into a free slot on the GPU and fences the copy. ReadbackBuffer::read only hands out slots whose
+ * fence has signaled, so results arrive a few frames late but never stall. If all slots are in flight, the request is
+ * dropped and the source keeps its contents.
+ * @tparam T The type of object stored in the buffer.
+ */
+template <typename T>
+class ReadbackBuffer
+{
+public:
+    /** @brief The default number of slots, allows the GPU to be two requests behind. */
+    static constexpr int defaultSlotCount = 3;
+
+    /**
+     * @brief Creates and maps the buffer storage.
+     * @param count The number of elements per slot.
+     * @param slotCount The number of fence guarded slots.
+     */
+    explicit ReadbackBuffer(GLsizeiptr count = 0, int slotCount = defaultSlotCount);
+
+    /** @brief Hands the pending fences to the GlDeletionQueue without waiting, their results are discarded. */
+    ~ReadbackBuffer();
+
+    ReadbackBuffer(const ReadbackBuffer& other) = delete;
+    ReadbackBuffer& operator=(const ReadbackBuffer& other) = delete;
+
+    /**
+     * @brief Moving a readback buffer transfers the mapping and the pending requests.
+     * @param other ReadbackBuffer to move.
+     */
+    ReadbackBuffer(ReadbackBuffer&& other) noexcept;
+    ReadbackBuffer& operator=(ReadbackBuffer&& other) noexcept;
+
+    /**
+     * @brief Copies the first ReadbackBuffer::size elements of the source to a free slot. Shader writes to the source
+     * are made visible to the copy.
+     * @param source The buffer to read back, has to hold at least ReadbackBuffer::size elements.
+     * @param tag A value that is passed to the read callback with the data, e.g. the frame number.
+     * @return false if all slots are in flight and nothing was copied.
+     */
+    bool request(const Buffer<T>& source, uint64_t tag);
+
+    /**
+     * @brief Passes the data of all slots whose copies have finished to the callback and frees the slots.
+     * @param callback Called as callback(const T* data, uint64_t tag) with ReadbackBuffer::size elements, oldest first.
+     * @return The number of finished slots.
+     */
+    template <typename Callback>
+    int read(Callback&& callback);
+
+    /**
+     * @return The number of elements per slot.
+     */
+    GLsizeiptr size() const;
+
+private:
+    struct Slot
+    {
+        GLsync fence = nullptr;
+        uint64_t tag = 0;
+    };
+
+    /** @brief Hands all fences to the GlDeletionQueue, so destruction never calls OpenGL on the releasing thread. */
+    void releaseFences();
+
+    GLbuffer          m_buffer;
+    const T*          m_data = nullptr;
+    GLsizeiptr        m_count = 0;
+    std::vector<Slot> m_slots;
+};
+
+#include "ReadbackBuffer.inl"
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+
+template <typename T>
+ReadbackBuffer<T>::ReadbackBuffer(GLsizeiptr count, int slotCount)
+    : m_buffer(glCreateBufferRAII()), m_count(count), m_slots(slotCount)
+{
+    if (m_count == 0)
+        return;
+
+    const auto flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glNamedBufferStorage(*m_buffer, m_count * slotCount * sizeof(T), nullptr, flags);
+    m_data = static_cast<const T*>(glMapNamedBufferRange(*m_buffer, 0, m_count * slotCount * sizeof(T), flags));
+}
+
+template <typename T>
+ReadbackBuffer<T>::~ReadbackBuffer()
+{
+    releaseFences();
+}
+
+template <typename T>
+ReadbackBuffer<T>::ReadbackBuffer(ReadbackBuffer&& other) noexcept
+    : m_buffer(std::move(other.m_buffer))
+    , m_data(other.m_data)
+    , m_count(other.m_count)
+    , m_slots(std::move(other.m_slots))
+{
+    other.m_data = nullptr;
+    other.m_count = 0;
+    other.m_slots.clear();
+}
+
+template <typename T>
+ReadbackBuffer<T>& ReadbackBuffer<T>::operator=(ReadbackBuffer&& other) noexcept
+{
+    releaseFences();
+
+    m_buffer = std::move(other.m_buffer);
+    m_data   = other.m_data;
+    m_count  = other.m_count;
+    m_slots  = std::move(other.m_slots);
+
+    other.m_data = nullptr;
+    other.m_count = 0;
+    other.m_slots.clear();
+    return *this;
+}
+
+template <typename T>
+bool ReadbackBuffer<T>::request(const Buffer<T>& source, uint64_t tag)
+{
+    assert(source.size() >= m_count && "The source buffer is too small.");
+
+    const auto slot = std::find_if(m_slots.begin(), m_slots.end(), [](const Slot& s) { return !s.fence; });
+    if (m_count == 0 || slot == m_slots.end())
+        return false;
+
+    const GLintptr offset = (slot - m_slots.begin()) * m_count * sizeof(T);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glCopyNamedBufferSubData(*source.id(), *m_buffer, 0, offset, m_count * sizeof(T));
+
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+    slot->tag = tag;
+    return true;
+}
+
+template <typename T>
+template <typename Callback>
+int ReadbackBuffer<T>::read(Callback&& callback)
+{
+    std::vector<int> finished;
+    for (int slot = 0; slot < static_cast<int>(m_slots.size()); ++slot)
+    {
+        if (m_slots[slot].fence && glClientWaitSync(m_slots[slot].fence, GL_NONE_BIT, 0) != GL_TIMEOUT_EXPIRED)
+            finished.push_back(slot);
+    }
+    std::sort(finished.begin(), finished.end(), [this](int a, int b) { return m_slots[a].tag < m_slots[b].tag; });
+
+    for (const int slot : finished)
+    {
+        glDeleteSync(m_slots[slot].fence);
+        m_slots[slot].fence = nullptr;
+        callback(m_data + slot * m_count, m_slots[slot].tag);
+    }
+    return static_cast<int>(finished.size());
+}
+
+template <typename T>
+GLsizeiptr ReadbackBuffer<T>::size() const
+{
+    return m_count;
+}
+
+template <typename T>
+void ReadbackBuffer<T>::releaseFences()
+{
+    for (auto& slot : m_slots)
+    {
+        if (slot.fence)
+            GlDeletionQueue::get().enqueue(slot.fence);
+        slot.fence = nullptr;
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <glbinding/gl/gl.h>
+#include <vector>
+#include <variant>
+#include "Binding.hpp"
+#include "OpenGL_RAII.hpp"
+
+using namespace gl;
+
+/**
+ * @brief A persistently and coherently mapped buffer for data that is rewritten every frame, e.g. uniform buffers.
+ * @details The storage is split into regions that are filled one after another. Every push writes to fresh memory
+ * through the mapped pointer, so the GPU can still read older data without the driver copying or synchronizing.
+ * When a region is full, a fence is inserted and the next region is used. Before a region is written again, its
+ * fence is waited for, which only blocks if the GPU is more than (regionCount - 1) regions behind.
+ * @tparam T The type of object stored in the buffer.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+    /** @brief The default number of regions, allows the CPU to run two regions ahead of the GPU. */
+    static constexpr int defaultRegionCount = 3;
+
+    /**
+     * @brief Creates and maps the buffer storage.
+     * @param countPerRegion The number of elements that fit into one region, i.e. the expected number of pushes
+     * per frame for single elements.
+     * @param regionCount The number of fence guarded regions.
+     */
+    explicit RingBuffer(GLsizeiptr countPerRegion, int regionCount = defaultRegionCount);
+
+    /**
+     * @brief Does not wait for the GPU, the buffer and the remaining fences are deleted through the GlDeletionQueue.
+     * The mapping is released with the buffer.
+     */
+    ~RingBuffer();
+
+    RingBuffer(const RingBuffer& other) = delete;
+    RingBuffer& operator=(const RingBuffer& other) = delete;
+
+    /**
+     * @brief Moving a ring buffer transfers the mapping and the fences.
+     * @param other RingBuffer to move.
+     */
+    RingBuffer(RingBuffer&& other) noexcept;
+    RingBuffer& operator=(RingBuffer&& other) noexcept;
+
+    /**
+     * @brief Writes one element to the next free range of the current region.
+     * @param data The element to write.
+     * @return The byte offset of the written range.
+     */
+    GLintptr push(const T& data);
+
+    /**
+     * @brief Writes consecutive elements to the next free range of the current region.
+     * @param data A vector to be written.
+     * @return The byte offset of the written range.
+     */
+    GLintptr push(const std::vector<T>& data);
+
+    /**
+     * @brief Writes consecutive elements to the next free range of the current region.
+     * @param data A data pointer containing the elements to write.
+     * @param count The number of elements to write, at most countPerRegion.
+     * @return The byte offset of the written range.
+     */
+    GLintptr push(const T* data, GLsizeiptr count);
+
+    /**
+     * @brief Binds the range of the last push to an opengl target at a given binding index using glBindBufferRange.
+     * @param target The OpenGL buffer binding target.
+     * @param index The binding index to bind to.
+     */
+    void bind(GLenum target, std::variant<GLuint, BufferBinding> index) const;
+
+    /**
+     * @return The number of elements written by the last push.
+     */
+    GLsizeiptr size() const;
+
+    /**
+     * @return The OpenGL buffer name (ID).
+     */
+    GLbuffer id() const;
+
+private:
+    /** @brief Fences the current region and waits until the GPU has finished reading the next one. */
+    void nextRegion();
+
+    /** @brief Blocks until the given region is not read anymore and deletes its fence. */
+    void waitForRegion(int region);
+
+    /** @brief Hands all fences to the GlDeletionQueue without waiting for them. */
+    void releaseFences();
+
+    GLbuffer            m_buffer;
+    std::byte*          m_data = nullptr;
+    GLsizeiptr          m_regionSize = 0;   // in bytes
+    GLsizeiptr          m_alignment = 1;
+    int                 m_regionCount = 0;
+    int                 m_region = 0;
+    GLintptr            m_head = 0;         // next free byte in the current region
+    GLintptr            m_lastOffset = 0;
+    GLsizeiptr          m_lastCount = 0;
+    std::vector<GLsync> m_fences;
+};
+
+#include "RingBuffer.inl"
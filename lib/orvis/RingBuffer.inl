@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+template <typename T>
+RingBuffer<T>::RingBuffer(GLsizeiptr countPerRegion, int regionCount)
+    : m_buffer(glCreateBufferRAII()), m_regionCount(regionCount), m_fences(regionCount, nullptr)
+{
+    // every push starts at an offset that is valid for uniform and shader storage bindings
+    GLint uniformAlignment = 1;
+    GLint storageAlignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+    m_alignment = std::max(uniformAlignment, storageAlignment);
+
+    const GLsizeiptr elementSize = (sizeof(T) + m_alignment - 1) / m_alignment * m_alignment;
+    m_regionSize = countPerRegion * elementSize;
+
+    const auto flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glNamedBufferStorage(*m_buffer, m_regionSize * m_regionCount, nullptr, flags);
+    m_data = static_cast<std::byte*>(glMapNamedBufferRange(*m_buffer, 0, m_regionSize * m_regionCount, flags));
+}
+
+template <typename T>
+RingBuffer<T>::~RingBuffer()
+{
+    // the buffer is deleted by the GlDeletionQueue after the GPU is done with it, unmapping is done by RAII
+    releaseFences();
+}
+
+template <typename T>
+RingBuffer<T>::RingBuffer(RingBuffer&& other) noexcept
+    : m_buffer(std::move(other.m_buffer))
+    , m_data(other.m_data)
+    , m_regionSize(other.m_regionSize)
+    , m_alignment(other.m_alignment)
+    , m_regionCount(other.m_regionCount)
+    , m_region(other.m_region)
+    , m_head(other.m_head)
+    , m_lastOffset(other.m_lastOffset)
+    , m_lastCount(other.m_lastCount)
+    , m_fences(std::move(other.m_fences))
+{
+    other.m_data = nullptr;
+    other.m_fences.clear();
+}
+
+template <typename T>
+RingBuffer<T>& RingBuffer<T>::operator=(RingBuffer&& other) noexcept
+{
+    releaseFences();
+
+    m_buffer      = std::move(other.m_buffer);
+    m_data        = other.m_data;
+    m_regionSize  = other.m_regionSize;
+    m_alignment   = other.m_alignment;
+    m_regionCount = other.m_regionCount;
+    m_region      = other.m_region;
+    m_head        = other.m_head;
+    m_lastOffset  = other.m_lastOffset;
+    m_lastCount   = other.m_lastCount;
+    m_fences      = std::move(other.m_fences);
+    other.m_data = nullptr;
+    other.m_fences.clear();
+    return *this;
+}
+
+template <typename T>
+GLintptr RingBuffer<T>::push(const T& data)
+{
+    return push(&data, 1);
+}
+template <typename T>
+GLintptr RingBuffer<T>::push(const std::vector<T>& data)
+{
+    return push(std::data(data), std::size(data));
+}
+template <typename T>
+GLintptr RingBuffer<T>::push(const T* data, GLsizeiptr count)
+{
+    const GLsizeiptr bytes = (count * sizeof(T) + m_alignment - 1) / m_alignment * m_alignment;
+    assert(bytes <= m_regionSize && "Push does not fit into one region.");
+
+    if (m_head + bytes > m_regionSize)
+        nextRegion();
+
+    m_lastOffset = m_region * m_regionSize + m_head;
+    m_lastCount = count;
+    std::memcpy(m_data + m_lastOffset, data, count * sizeof(T));
+    m_head += bytes;
+    return m_lastOffset;
+}
+
+template <typename T>
+void RingBuffer<T>::bind(GLenum target, std::variant<GLuint, BufferBinding> index) const
+{
+    assert(m_lastCount > 0 && "Nothing pushed yet.");
+    const GLuint i = std::holds_alternative<GLuint>(index) ? std::get<GLuint>(index) : static_cast<GLuint>(std::get<BufferBinding>(index));
+    GlState::get().bindBufferRange(target, i, *m_buffer, m_lastOffset, m_lastCount * sizeof(T));
+}
+
+template <typename T>
+GLsizeiptr RingBuffer<T>::size() const
+{
+    return m_lastCount;
+}
+
+template <typename T>
+GLbuffer RingBuffer<T>::id() const
+{
+    return m_buffer;
+}
+
+template <typename T>
+void RingBuffer<T>::nextRegion()
+{
+    // all commands reading the current region have been issued before this fence
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+    m_region = (m_region + 1) % m_regionCount;
+    m_head = 0;
+    waitForRegion(m_region);
+}
+
+template <typename T>
+void RingBuffer<T>::releaseFences()
+{
+    for (GLsync& fence : m_fences)
+    {
+        if (fence)
+            GlDeletionQueue::get().enqueue(fence);
+        fence = nullptr;
+    }
+}
+
+template <typename T>
+void RingBuffer<T>::waitForRegion(int region)
+{
+    if (!m_fences[region])
+        return;
+
+    constexpr GLuint64 timeout = 1000000000; // 1 s, expiring only means that the GPU is still busy
+    GLenum result = glClientWaitSync(m_fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    while (result == GL_TIMEOUT_EXPIRED)
+        result = glClientWaitSync(m_fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+
+    glDeleteSync(m_fences[region]);
+    m_fences[region] = nullptr;
+}
@@ -1,17 +1,37 @@
 #include "Scene.hpp"
+#include "GlState.hpp"
+#include "GlProfiler.hpp"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <assimp/config.h>
 
+#include <algorithm>
+#include <iterator>
 #include <numeric>
 #include <execution>
 
 #include "Util.hpp"
 #include "stb/stb_image.h"
 
+namespace
+{
+    /** @return The ascending indices of all non-zero flags. */
+    std::vector<GLsizeiptr> getDirtyIndices(const std::vector<char>& dirty)
+    {
+        std::vector<GLsizeiptr> indices;
+        for (size_t i = 0; i < dirty.size(); ++i)
+        {
+            if (dirty[i])
+                indices.push_back(static_cast<GLsizeiptr>(i));
+        }
+        return indices;
+    }
+}
+
 Scene::Scene(const std::filesystem::path& filename)
+    : m_lightIndexBuffer(maxShadowMapsPerFrame), m_viewBuffer(maxViewCount * 4)
 {
     const auto path = util::resourcesPath / filename;
     const auto pathString = path.string();
@@ -90,9 +110,26 @@ Scene::Scene(const std::filesystem::path& filename)
 
         updateMaterialBuffer();
 
-        m_cullingProgram.attachNew(GL_COMPUTE_SHADER, ShaderFile::load("compute/viewFrustumCulling.comp"));
+        // one variant per culling mode, shading passes request all material textures, depth passes only alpha tested ones
+        const std::array<const char*, 3> cullingModeDefines = { nullptr, "CUBE_MAP_CULLING", "MULTI_VIEW_CULLING" };
+        for (size_t mode = 0; mode < cullingModeDefines.size(); ++mode)
+        {
+            std::vector<glsp::definition> cullingDefines = binding::defaultShaderDefines;
+            if (cullingModeDefines[mode])
+                cullingDefines.emplace_back(cullingModeDefines[mode]);
+            cullingDefines.emplace_back("MATERIAL_USAGE");
+            m_cullingPrograms[mode].attach(std::make_shared<Shader>(GL_COMPUTE_SHADER, ShaderFile::load("compute/viewFrustumCulling.comp"), cullingDefines));
+
+            cullingDefines.back() = glsp::definition("ALPHA_TEST_MATERIAL_USAGE");
+            m_depthCullingPrograms[mode].attach(std::make_shared<Shader>(GL_COMPUTE_SHADER, ShaderFile::load("compute/viewFrustumCulling.comp"), cullingDefines));
+        }
+
+        std::vector<glsp::definition> depthOnlyDefines = binding::defaultShaderDefines;
+        depthOnlyDefines.emplace_back("DEPTH_ONLY");
+        m_depthPrepassProgram.attach(std::make_shared<Shader>(GL_VERTEX_SHADER, ShaderFile::load("vertex/multiDraw.vert"), depthOnlyDefines));
 
-        m_lightIndexBuffer.resize(1, GL_DYNAMIC_STORAGE_BIT);
+        depthOnlyDefines.emplace_back("MULTIVIEW");
+        m_multiViewDepthPrepassProgram.attach(std::make_shared<Shader>(GL_VERTEX_SHADER, ShaderFile::load("vertex/multiDraw.vert"), depthOnlyDefines));
     }
 
     modelMatThread.join();
@@ -105,27 +142,160 @@ Scene::Scene(const std::filesystem::path& filename)
     importer.FreeScene();
 }
 
-void Scene::render(const Program& program, bool overwriteCameraBuffer) const
+void Scene::render(const Program& program, bool overwriteCameraBuffer, CullingMode cullingMode) const
+{
+    renderWithPrograms([&program](GLuint) -> const Program& { return program; }, overwriteCameraBuffer, cullingMode);
+}
+
+void Scene::render(const MaterialProgram& program, bool overwriteCameraBuffer, CullingMode cullingMode) const
+{
+    renderWithPrograms([&program](GLuint materialFeatures) -> const Program& { return program.get(materialFeatures); },
+        overwriteCameraBuffer, cullingMode);
+}
+
+void Scene::renderWithPrograms(const ProgramSelector& selectProgram, bool overwriteCameraBuffer, CullingMode cullingMode) const
+{
+    GlProfiler::Scope profilerScope("Scene::render");
+    cull(overwriteCameraBuffer, cullingMode, false);
+
+    const auto drawCount = static_cast<GLsizei>(m_indirectDrawBuffer.size());
+    if (!m_depthPrepass || m_opaqueDrawCount == 0)
+    {
+        drawShaded(selectProgram, 0, drawCount);
+        return;
+    }
+
+    // the state of the caller is restored afterwards, the prepass uses its depth function
+    GlState& state = GlState::get();
+    const GLenum depthFunc = state.getDepthFunc();
+    const bool depthMask = state.getDepthMask();
+    const glm::bvec4 colorMask = state.getColorMask();
+
+    // DEPTH PREPASS (opaque meshes only)
+    state.setColorMask(glm::bvec4(false));
+    if (cullingMode == CullingMode::multiView)
+        m_multiViewDepthPrepassProgram.use();
+    else
+        m_depthPrepassProgram.use();
+    drawIndirect(m_depthVao, 0, m_opaqueDrawCount);
+    state.setColorMask(colorMask);
+
+    // SHADING (only the visible fragment of every pixel passes)
+    state.setDepthFunc(GL_EQUAL);
+    state.setDepthMask(false);
+    drawShaded(selectProgram, 0, m_opaqueDrawCount);
+    state.setDepthFunc(depthFunc);
+    state.setDepthMask(depthMask);
+
+    // transparent meshes are blended and have no depth in the prepass
+    if (drawCount > m_opaqueDrawCount)
+        drawShaded(selectProgram, m_opaqueDrawCount, drawCount - m_opaqueDrawCount);
+}
+
+void Scene::drawShaded(const ProgramSelector& selectProgram, GLsizei first, GLsizei count) const
+{
+    const GLsizei last = first + count;
+    const Program* currentProgram = nullptr;
+    GLsizei currentFirst = first;
+
+    for (const auto& range : m_materialRanges)
+    {
+        const GLsizei rangeFirst = std::max(range.first, first);
+        if (rangeFirst >= std::min(range.first + range.count, last))
+            continue;
+
+        const Program& program = selectProgram(range.materialFeatures);
+        if (&program == currentProgram)
+            continue;
+
+        if (currentProgram)
+            drawIndirect(m_multiDrawVao, currentFirst, rangeFirst - currentFirst);
+        program.use();
+        currentProgram = &program;
+        currentFirst = rangeFirst;
+    }
+
+    if (currentProgram)
+        drawIndirect(m_multiDrawVao, currentFirst, last - currentFirst);
+}
+
+void Scene::bindGeometryBuffers() const
+{
+    m_multiDrawIndexBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::multiDrawIndices);
+    m_multiDrawVertexBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::multiDrawVertices);
+    m_multiDrawNormalBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::multiDrawNormals);
+    m_multiDrawUVBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::multiDrawTexCoords);
+}
+
+void Scene::setDepthPrepass(bool enabled)
+{
+    m_depthPrepass = enabled;
+}
+
+bool Scene::getDepthPrepass() const
+{
+    return m_depthPrepass;
+}
+
+void Scene::setViews(const std::vector<GpuCamera>& views)
+{
+    assert(!views.empty() && views.size() <= static_cast<size_t>(maxViewCount) && "Invalid number of views");
+
+    m_viewBuffer.push(views);
+}
+
+void Scene::renderDepth(const Program& depthProgram, const Program& alphaTestProgram, bool overwriteCameraBuffer,
+    CullingMode cullingMode) const
+{
+    GlProfiler::Scope profilerScope("Scene::renderDepth");
+    cull(overwriteCameraBuffer, cullingMode, true);
+
+    // opaque meshes only read positions
+    if (m_opaqueDrawCount > 0)
+    {
+        depthProgram.use();
+        drawIndirect(m_depthVao, 0, m_opaqueDrawCount);
+    }
+
+    // transparent meshes need texture coordinates for the alpha test
+    const auto drawCount = static_cast<GLsizei>(m_indirectDrawBuffer.size());
+    if (drawCount > m_opaqueDrawCount)
+    {
+        alphaTestProgram.use();
+        drawIndirect(m_multiDrawVao, m_opaqueDrawCount, drawCount - m_opaqueDrawCount);
+    }
+}
+
+void Scene::cull(bool overwriteCameraBuffer, CullingMode cullingMode, bool depthOnly) const
 {
     // BINDINGS
     m_indirectDrawBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::indirectDraw);
     m_bBoxBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::boundingBoxes);
-    m_modelMatBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::modelMatrices);
+    m_instanceBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::instanceData);
     m_materialBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::materials);
+    m_textureResidency.bind();
+    m_textureStreaming.bind();
     m_lightBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::lights);
     if (overwriteCameraBuffer)
         m_camera->uploadToGpu();
 
     // CULLING
-    m_cullingProgram.use();
+    // a single pass for all views, every draw is instanced once per view that sees it
+    if (cullingMode == CullingMode::multiView)
+        m_viewBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::views);
+    const auto mode = static_cast<size_t>(cullingMode);
+    (depthOnly ? m_depthCullingPrograms[mode] : m_cullingPrograms[mode]).use();
     glDispatchCompute(static_cast<GLuint>(glm::ceil(m_indirectDrawBuffer.size() / 64.0f)), 1, 1);
     glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
 
-    // DRAW
-    program.use();
-    m_multiDrawVao.bind();
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, *m_indirectDrawBuffer.id());
-    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(m_indirectDrawBuffer.size()), 0);
+void Scene::drawIndirect(const VertexArray& vao, GLsizei first, GLsizei count) const
+{
+    // the draw index is taken from the base instance, so subranges keep their material and model matrix
+    vao.bind();
+    GlState::get().bindBuffer(GL_DRAW_INDIRECT_BUFFER, *m_indirectDrawBuffer.id());
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+        reinterpret_cast<const void*>(static_cast<GLintptr>(first) * sizeof(IndirectDrawCommand)), count, 0);
 }
 
 const Bounds& Scene::calculateBoundingBox()
@@ -160,44 +330,182 @@ const Bounds& Scene::calculateBoundingBox()
 
 void Scene::updateModelMatrices()
 {
-    std::vector<glm::mat4> modelMatrices(m_meshes.size());
+    static_assert(sizeof(InstanceData) == 160, "InstanceData has to match the std430 layout in instanceData.glsl");
+
+    // meshes that were not uploaded before have no motion
+    const size_t uploadedCount = m_instances.size();
+    m_instances.resize(m_meshes.size());
+    std::vector<char> dirty(m_instances.size(), 0);
 
 #pragma omp parallel for
-    for (int i = 0; i < static_cast<int>(modelMatrices.size()); ++i)
-        modelMatrices[i] = m_meshes[i]->modelMatrix;
+    for (int i = 0; i < static_cast<int>(m_instances.size()); ++i)
+    {
+        InstanceData& instance = m_instances[i];
+        const glm::mat4& modelMatrix = m_meshes[i]->modelMatrix;
+        const glm::mat3x4 model = glm::mat3x4(glm::transpose(modelMatrix));
+        const bool added = i >= static_cast<int>(uploadedCount);
+
+        // a mesh that moved in the previous update still has to catch up with its previous model matrix
+        if (!added && instance.modelMatrix == model && instance.previousModelMatrix == model)
+            continue;
+
+        instance.previousModelMatrix = added ? model : instance.modelMatrix;
+        instance.modelMatrix = model;
+        instance.normalMatrix = glm::mat3x4(glm::mat4(glm::transpose(glm::inverse(glm::mat3(modelMatrix)))));
+        // updateMaterialBuffer fills in the indices of new meshes
+        if (added)
+        {
+            instance.materialIndex = i < static_cast<int>(m_materialIndices.size()) ? m_materialIndices[i] : 0;
+            instance.alphaTested = m_meshes[i]->isTransparent() ? 1u : 0u;
+        }
+        dirty[i] = 1;
+    }
 
-    if (modelMatrices.size() != static_cast<size_t>(m_modelMatBuffer.size()))
-        m_modelMatBuffer.resize(modelMatrices.size(), GL_DYNAMIC_STORAGE_BIT);
+    if (m_instances.size() != static_cast<size_t>(m_instanceBuffer.size()))
+        m_instanceBuffer.resize(m_instances.size(), GL_DYNAMIC_STORAGE_BIT);
 
-    m_modelMatBuffer.assign(modelMatrices);
+    m_instanceBuffer.assignDirty(m_instances, getDirtyIndices(dirty));
 }
 
 void Scene::updateBoundingBoxBuffer()
 {
-    std::vector<Bounds> boundingBoxes(m_meshes.size());
+    const size_t uploadedCount = m_boundingBoxes.size();
+    m_boundingBoxes.resize(m_meshes.size());
+    std::vector<char> dirty(m_boundingBoxes.size(), 0);
 
 #pragma omp parallel for
-    for (int i = 0; i < static_cast<int>(boundingBoxes.size()); ++i)
-        boundingBoxes[i] = m_meshes[i]->bounds;
+    for (int i = 0; i < static_cast<int>(m_boundingBoxes.size()); ++i)
+    {
+        if (i < static_cast<int>(uploadedCount) && m_boundingBoxes[i] == m_meshes[i]->bounds)
+            continue;
+
+        m_boundingBoxes[i] = m_meshes[i]->bounds;
+        dirty[i] = 1;
+    }
 
-    if (boundingBoxes.size() != static_cast<size_t>(m_bBoxBuffer.size()))
-        m_bBoxBuffer.resize(boundingBoxes.size(), GL_DYNAMIC_STORAGE_BIT);
+    if (m_boundingBoxes.size() != static_cast<size_t>(m_bBoxBuffer.size()))
+        m_bBoxBuffer.resize(m_boundingBoxes.size(), GL_DYNAMIC_STORAGE_BIT);
 
-    m_bBoxBuffer.assign(boundingBoxes);
+    m_bBoxBuffer.assignDirty(m_boundingBoxes, getDirtyIndices(dirty));
 }
 
 void Scene::updateMaterialBuffer()
 {
-    std::vector<Material> materials(m_meshes.size());
+    const size_t uploadedCount = m_materialIndices.size();
+    m_materialIndices.resize(m_meshes.size());
+    std::vector<char> dirty(m_materialIndices.size(), 0);
 
 #pragma omp parallel for
-    for (int i = 0; i < static_cast<int>(materials.size()); ++i)
-        materials[i] = m_meshes[i]->material;
+    for (int i = 0; i < static_cast<int>(m_materialIndices.size()); ++i)
+        dirty[i] = i >= static_cast<int>(uploadedCount) || m_materials[m_materialIndices[i]] != m_meshes[i]->material;
+
+    const std::vector<GLsizeiptr> changedMeshes = getDirtyIndices(dirty);
+    if (changedMeshes.empty())
+        return;
 
-    if (materials.size() != static_cast<size_t>(m_materialBuffer.size()))
-        m_materialBuffer.resize(materials.size(), GL_DYNAMIC_STORAGE_BIT);
+    // materials are only added here, the unused ones are dropped when the meshes are reordered
+    for (const GLsizeiptr i : changedMeshes)
+    {
+        const auto [material, inserted] = m_materialLookup.try_emplace(m_meshes[i]->material, static_cast<GLuint>(m_materials.size()));
+        if (inserted)
+            m_materials.push_back(m_meshes[i]->material);
+        m_materialIndices[i] = material->second;
+    }
 
-    m_materialBuffer.assign(materials);
+    const GLsizeiptr uploadedMaterials = m_materialBuffer.size();
+    m_materialBuffer.append(m_materials.data() + uploadedMaterials, static_cast<GLsizeiptr>(m_materials.size()) - uploadedMaterials);
+
+    // equal materials reference the same handles, so the textures of a material only change with new materials
+    if (static_cast<GLsizeiptr>(m_materials.size()) != uploadedMaterials)
+        updateMaterialTextures();
+
+    // the instance data is missing while the constructor is running, updateModelMatrices picks the indices up then
+    if (m_instances.size() == m_meshes.size())
+    {
+        for (const GLsizeiptr i : changedMeshes)
+            m_instances[i].materialIndex = m_materialIndices[i];
+        m_instanceBuffer.assignDirty(m_instances, changedMeshes);
+    }
+
+    updateMaterialRanges();
+}
+
+void Scene::updateMaterialRanges()
+{
+    m_materialRanges.clear();
+    for (int i = 0; i < static_cast<int>(m_meshes.size()); ++i)
+    {
+        const GLuint materialFeatures = m_meshes[i]->material.getTextureBitset();
+        const bool startsRange = i == 0 || m_materialRanges.back().materialFeatures != materialFeatures
+            || m_meshes[i - 1]->isTransparent() != m_meshes[i]->isTransparent();
+
+        if (startsRange)
+            m_materialRanges.push_back({ materialFeatures, i, 0 });
+        ++m_materialRanges.back().count;
+    }
+}
+
+size_t Scene::getUniqueMaterialCount() const
+{
+    return static_cast<size_t>(m_materialBuffer.size());
+}
+
+void Scene::updateMaterialTextures()
+{
+    std::vector<std::vector<std::shared_ptr<Texture>>> materialTextures(m_materials.size());
+    std::vector<bool> found(m_materials.size(), false);
+    for (size_t i = 0; i < m_meshes.size(); ++i)
+    {
+        const GLuint material = m_materialIndices[i];
+        if (found[material])
+            continue;
+        found[material] = true;
+        for (const auto& [type, texture] : m_meshes[i]->m_textures)
+            materialTextures[material].push_back(texture);
+    }
+    m_textureResidency.setMaterials(materialTextures);
+    m_textureStreaming.setMaterials(materialTextures);
+}
+
+TextureResidency& Scene::getTextureResidency()
+{
+    return m_textureResidency;
+}
+
+TextureStreaming& Scene::getTextureStreaming()
+{
+    return m_textureStreaming;
+}
+
+void Scene::updateTextureStreaming()
+{
+    const auto replacedHandles = m_textureStreaming.update();
+    if (replacedHandles.empty())
+        return;
+
+    for (const auto& mesh : m_meshes)
+    {
+        for (const auto& [oldHandle, newHandle] : replacedHandles)
+            mesh->material.replaceHandle(oldHandle, newHandle);
+    }
+
+    // patch the unique materials in place, so the material indices of the draws stay valid
+    std::vector<GLsizeiptr> changedMaterials;
+    for (GLsizeiptr i = 0; i < static_cast<GLsizeiptr>(m_materials.size()); ++i)
+    {
+        Material material = m_materials[i];
+        bool replaced = false;
+        for (const auto& [oldHandle, newHandle] : replacedHandles)
+            replaced = material.replaceHandle(oldHandle, newHandle) || replaced;
+        if (!replaced)
+            continue;
+
+        m_materialLookup.erase(m_materials[i]);
+        m_materials[i] = material;
+        m_materialLookup.emplace(material, static_cast<GLuint>(i));
+        changedMaterials.push_back(i);
+    }
+    m_materialBuffer.assignDirty(m_materials, changedMaterials);
 }
 
 void Scene::updateLightBuffer()
@@ -221,7 +529,7 @@ void Scene::updateShadowMaps()
 {
     for (int i = 0; i < static_cast<int>(m_lights.size()); ++i)
     {
-        m_lightIndexBuffer.assign(i);
+        m_lightIndexBuffer.push(i);
         m_lightIndexBuffer.bind(GL_UNIFORM_BUFFER, BufferBinding::lightIndex);
         m_lights[i]->updateShadowMap(*this);
     }
@@ -232,7 +540,8 @@ void Scene::addMesh(const std::shared_ptr<Mesh>& mesh)
     m_meshes.push_back(mesh);
     std::thread bBoxThread([&]() { calculateBoundingBox(); });
     updateModelMatrices();
-    updateMultiDrawBuffers();
+    // the geometry of the other meshes stays in place, only the new mesh is uploaded
+    appendMultiDrawBuffers(*mesh);
     updateBoundingBoxBuffer();
     updateMaterialBuffer();
     bBoxThread.join();
@@ -263,17 +572,34 @@ const std::deque<std::shared_ptr<Mesh>>& Scene::getMeshes() const
 
 void Scene::reorderMeshes()
 {
-    std::deque<std::shared_ptr<Mesh>> orderedMeshes;
+    // opaque meshes first, then grouped by material variant
+    std::vector<size_t> order(m_meshes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b)
+    {
+        const auto keyA = std::make_pair(m_meshes[a]->isTransparent(), m_meshes[a]->material.getTextureBitset());
+        const auto keyB = std::make_pair(m_meshes[b]->isTransparent(), m_meshes[b]->material.getTextureBitset());
+        return keyA < keyB;
+    });
 
-    for (const auto& mesh : m_meshes)
+    // the instance data moves along with its mesh, so the previous model matrices stay valid
+    std::deque<std::shared_ptr<Mesh>> meshes;
+    std::vector<InstanceData> instances;
+    for (const size_t i : order)
     {
-        if (mesh->isTransparent())
-            orderedMeshes.push_back(mesh);
-        else
-            orderedMeshes.push_front(mesh);
+        meshes.push_back(m_meshes[i]);
+        if (i < m_instances.size())
+            instances.push_back(m_instances[i]);
     }
+    m_meshes = std::move(meshes);
+    m_instances = std::move(instances);
+    m_instanceBuffer.assign(m_instances);
 
-    m_meshes = orderedMeshes;
+    // rebuild the materials from scratch, which also drops the ones that are not used anymore
+    m_materials.clear();
+    m_materialLookup.clear();
+    m_materialIndices.clear();
+    m_materialBuffer.resize(0, GL_DYNAMIC_STORAGE_BIT);
 
     updateModelMatrices();
     updateMultiDrawBuffers();
@@ -288,14 +614,22 @@ void Scene::updateMultiDrawBuffers()
     std::vector<glm::vec4> allNormals;
     std::vector<glm::vec2> allUVs;
 
+    std::vector<glm::vec3> allPositions;
+
     std::vector<IndirectDrawCommand> indirectDrawParams;
 
+    // transparent meshes are expected at the end (see Scene::reorderMeshes), everything before the first one is opaque
+    m_opaqueDrawCount = static_cast<GLsizei>(std::distance(m_meshes.begin(),
+        std::find_if(m_meshes.begin(), m_meshes.end(), [](const auto& mesh) { return mesh->isTransparent(); })));
+
     GLuint start = 0;
     GLuint baseVertexOffset = 0;
     for (const auto& mesh : m_meshes)
     {
         allIndices.insert(allIndices.end(), mesh->indices.begin(), mesh->indices.end());
         allVertices.insert(allVertices.end(), mesh->vertices.begin(), mesh->vertices.end());
+        std::transform(mesh->vertices.begin(), mesh->vertices.end(), std::back_inserter(allPositions),
+            [](const glm::vec4& v) { return glm::vec3(v); });
         allNormals.insert(allNormals.end(), mesh->normals.begin(), mesh->normals.end());
         allUVs.insert(allUVs.end(), mesh->uvs.begin(), mesh->uvs.end());
 
@@ -307,17 +641,57 @@ void Scene::updateMultiDrawBuffers()
         baseVertexOffset += static_cast<GLuint>(mesh->vertices.size());
     }
 
-    m_multiDrawIndexBuffer.resize(allIndices.size(), GL_DYNAMIC_STORAGE_BIT);
+    if (allIndices.size() != static_cast<size_t>(m_multiDrawIndexBuffer.size()))
+        m_multiDrawIndexBuffer.resize(allIndices.size(), GL_DYNAMIC_STORAGE_BIT);
     m_multiDrawIndexBuffer.assign(allIndices);
-    m_multiDrawVertexBuffer.resize(allVertices.size(), GL_DYNAMIC_STORAGE_BIT);
+    if (allVertices.size() != static_cast<size_t>(m_multiDrawVertexBuffer.size()))
+        m_multiDrawVertexBuffer.resize(allVertices.size(), GL_DYNAMIC_STORAGE_BIT);
     m_multiDrawVertexBuffer.assign(allVertices);
-    m_multiDrawNormalBuffer.resize(allNormals.size(), GL_DYNAMIC_STORAGE_BIT);
+    if (allNormals.size() != static_cast<size_t>(m_multiDrawNormalBuffer.size()))
+        m_multiDrawNormalBuffer.resize(allNormals.size(), GL_DYNAMIC_STORAGE_BIT);
     m_multiDrawNormalBuffer.assign(allNormals);
-    m_multiDrawUVBuffer.resize(allUVs.size(), GL_DYNAMIC_STORAGE_BIT);
+    if (allUVs.size() != static_cast<size_t>(m_multiDrawUVBuffer.size()))
+        m_multiDrawUVBuffer.resize(allUVs.size(), GL_DYNAMIC_STORAGE_BIT);
     m_multiDrawUVBuffer.assign(allUVs);
-    m_indirectDrawBuffer.resize(indirectDrawParams.size(), GL_DYNAMIC_STORAGE_BIT);
+    if (allPositions.size() != static_cast<size_t>(m_depthVertexBuffer.size()))
+        m_depthVertexBuffer.resize(allPositions.size(), GL_DYNAMIC_STORAGE_BIT);
+    m_depthVertexBuffer.assign(allPositions);
+    if (indirectDrawParams.size() != static_cast<size_t>(m_indirectDrawBuffer.size()))
+        m_indirectDrawBuffer.resize(indirectDrawParams.size(), GL_DYNAMIC_STORAGE_BIT);
     m_indirectDrawBuffer.assign(indirectDrawParams);
 
+    updateVertexArrays();
+}
+
+void Scene::appendMultiDrawBuffers(const Mesh& mesh)
+{
+    // a mesh appended after transparent meshes is drawn with the alpha tested ones, which is correct but slower
+    const auto drawCount = static_cast<GLsizei>(m_indirectDrawBuffer.size());
+    if (m_opaqueDrawCount == drawCount && !mesh.isTransparent())
+        ++m_opaqueDrawCount;
+
+    const auto count = static_cast<GLuint>(mesh.indices.size());
+    const auto start = static_cast<GLuint>(m_multiDrawIndexBuffer.size());
+    const auto baseVertexOffset = static_cast<GLuint>(m_multiDrawVertexBuffer.size());
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(mesh.vertices.size());
+    std::transform(mesh.vertices.begin(), mesh.vertices.end(), std::back_inserter(positions),
+        [](const glm::vec4& v) { return glm::vec3(v); });
+
+    m_multiDrawIndexBuffer.append(mesh.indices);
+    m_multiDrawVertexBuffer.append(mesh.vertices);
+    m_multiDrawNormalBuffer.append(mesh.normals);
+    m_multiDrawUVBuffer.append(mesh.uvs);
+    m_depthVertexBuffer.append(positions);
+    m_indirectDrawBuffer.push_back({ count, 1U, start, baseVertexOffset, 0U });
+
+    // growing may have replaced the storage of the buffers
+    updateVertexArrays();
+}
+
+void Scene::updateVertexArrays()
+{
     m_multiDrawVao.format(VertexAttributeBinding::vertices, 4, GL_FLOAT, false, 0);
     m_multiDrawVao.setVertexBuffer(m_multiDrawVertexBuffer, VertexAttributeBinding::vertices, 0, sizeof(glm::vec4));
     m_multiDrawVao.binding(VertexAttributeBinding::vertices);
@@ -331,4 +705,11 @@ void Scene::updateMultiDrawBuffers()
     m_multiDrawVao.binding(VertexAttributeBinding::texCoords);
 
     m_multiDrawVao.setElementBuffer(m_multiDrawIndexBuffer);
+
+    // w is filled with 1 by the vertex fetch
+    m_depthVao.format(VertexAttributeBinding::vertices, 3, GL_FLOAT, false, 0);
+    m_depthVao.setVertexBuffer(m_depthVertexBuffer, VertexAttributeBinding::vertices, 0, sizeof(glm::vec3));
+    m_depthVao.binding(VertexAttributeBinding::vertices);
+
+    m_depthVao.setElementBuffer(m_multiDrawIndexBuffer);
 }
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <array>
+#include <functional>
 #include "Bounds.hpp"
 #include "Light.hpp"
 #include "Mesh.hpp"
 #include "Camera.hpp"
+#include "MaterialProgram.hpp"
+#include "TextureResidency.hpp"
+#include "TextureStreaming.hpp"
 #include "VertexArray.hpp"
 
 // forward declarations
@@ -20,6 +25,25 @@ struct IndirectDrawCommand
     GLuint baseInstance;
 };
 
+/** @brief Per-draw data on the GPU, mirrors the struct in instanceData.glsl (std430). */
+struct InstanceData
+{
+    glm::mat3x4 modelMatrix;         //!< The first three rows of the affine model matrix.
+    glm::mat3x4 normalMatrix;        //!< transpose(inverse(modelMatrix)), columns padded to vec4.
+    glm::mat3x4 previousModelMatrix; //!< The model matrix of the previous update (for motion vectors), same layout as modelMatrix.
+    GLuint materialIndex;            //!< Index into the deduplicated material buffer.
+    GLuint alphaTested;              //!< 1 for transparent meshes, which depth passes draw with the alpha test.
+    GLuint padding[2];
+};
+
+/** @brief Selects against which frustums the GPU culling pass tests the meshes. */
+enum class CullingMode
+{
+    camera,     //!< Culls against the view frustum stored in the camera buffer.
+    cubeMap,    //!< Culls against all six faces of the point light selected by the light index buffer.
+    multiView   //!< Culls against all views set with Scene::setViews.
+};
+
 class Scene
 {
 public:
@@ -31,8 +55,52 @@ public:
     /** @brief Performs GPU view frustum culling and afterwards draws the scene indirectly. 
      * @param program The Shader program that is used to render the scene.
      * @param overwriteCameraBuffer If true, overwites the camera buffer with data from the attached camera-object before rendering
+     * @param cullingMode CullingMode::cubeMap writes the mask of visible cube faces to the lower bits of the base instance of each draw
+     * and issues one instance per visible face, so that all faces can be rendered in a single layered pass.
+     * CullingMode::multiView does the same for the views set with Scene::setViews, the program has to be compiled
+     * with MULTIVIEW (e.g. vertex/multiDraw.vert) and renders view i to layer i of a layered framebuffer.
+     * The upper bits of the base instance always hold the draw index (see drawID.glsl), use it instead of gl_DrawID.
      */
-    void render(const Program& program, bool overwriteCameraBuffer = true) const;
+    void render(const Program& program, bool overwriteCameraBuffer = true, CullingMode cullingMode = CullingMode::camera) const;
+
+    /** @brief Same as Scene::render(const Program&, bool, CullingMode), but draws the meshes with the MaterialProgram variant
+     * for their material texture bitset, one multi-draw per variant. Meshes are grouped by variant in Scene::reorderMeshes.
+     */
+    void render(const MaterialProgram& program, bool overwriteCameraBuffer = true, CullingMode cullingMode = CullingMode::camera) const;
+
+    /** @brief Sets the views for CullingMode::multiView, e.g. both eyes of a stereo camera.
+     * @param views Up to Scene::maxViewCount cameras, view i is rendered to layer i.
+     */
+    void setViews(const std::vector<GpuCamera>& views);
+
+    /** @brief The maximum number of views per multi-view pass, limited by the layer mask bits in the base instance. */
+    static constexpr int maxViewCount = 6;
+
+    /** @brief Enables or disables the depth prepass for Scene::render.
+     * If enabled, the depth of all opaque meshes is laid down first from the position-only vertex stream. Afterwards
+     * the opaque meshes are shaded with GL_EQUAL depth testing and without depth writes, so every pixel is shaded once.
+     * The program passed to Scene::render has to use vertex/multiDraw.vert, otherwise the depths will not match.
+     * Transparent meshes are drawn as before.
+     */
+    void setDepthPrepass(bool enabled);
+
+    /** @return true if Scene::render performs a depth prepass. */
+    bool getDepthPrepass() const;
+
+    /** @brief Performs GPU culling and afterwards draws the scene for depth-only passes.
+     * Opaque meshes are drawn from a position-only vertex stream with depthProgram, alpha-tested (transparent) meshes
+     * with the full vertex layout and alphaTestProgram.
+     * @param depthProgram The program used for opaque meshes. Only vertex positions are available.
+     * @param alphaTestProgram The program used for transparent meshes, positions, normals and texture coordinates are available.
+     * @param overwriteCameraBuffer If true, overwites the camera buffer with data from the attached camera-object before rendering
+     * @param cullingMode See Scene::render.
+     */
+    void renderDepth(const Program& depthProgram, const Program& alphaTestProgram, bool overwriteCameraBuffer = true, CullingMode cullingMode = CullingMode::camera) const;
+
+    /** @brief Binds the multi-draw index, vertex, normal and texture coordinate buffers as shader storage buffers,
+     * e.g. to reconstruct vertex attributes in compute passes.
+     */
+    void bindGeometryBuffers() const;
 
     /** @brief Calculates the bounding box around all transformed meshes.
     * Only has to be called if the bounds or the model-matrix of any mesh is changed.
@@ -40,15 +108,35 @@ public:
     */
     const Bounds& calculateBoundingBox();
 
-    /** @brief Fetches all model-matrices from all meshes and uploads them to the GPU. */
+    /** @brief Fetches all model-matrices from all meshes and uploads the ones that changed to the GPU as InstanceData.
+     * Also precomputes the normal matrices and keeps the model matrices of the previous call for motion vectors.
+     * Changes are found by comparing against the uploaded data, consecutive changed draws are uploaded with one copy.
+     */
     void updateModelMatrices();
 
-    /** @brief Fetches all bounding boxes from all meshes and uploads them to the GPU. */
+    /** @brief Fetches all bounding boxes from all meshes and uploads the ones that changed to the GPU. */
     void updateBoundingBoxBuffer();
 
-    /** @brief Fetches all materials from all meshes and uploads them to the GPU. */
+    /** @brief Fetches all materials from all meshes, deduplicates them by content and uploads the unique ones to the GPU.
+     * The material index of every draw is stored in its InstanceData. Only meshes whose material changed are looked up,
+     * new materials are appended to the buffer.
+     */
     void updateMaterialBuffer();
 
+    /** @return The number of distinct materials in the material buffer, including unused ones until Scene::reorderMeshes. */
+    size_t getUniqueMaterialCount() const;
+
+    /** @brief The residency manager of the material textures, its budget is unlimited by default.
+     * Call TextureResidency::update once per frame after rendering when a budget is set.
+     */
+    TextureResidency& getTextureResidency();
+
+    /** @brief The mip streaming of the material textures, enabled by default (see TextureStreaming::setEnabled). */
+    TextureStreaming& getTextureStreaming();
+
+    /** @brief Updates the texture streaming and points the materials to the reallocated textures. Call once per frame. */
+    void updateTextureStreaming();
+
     /** @brief Uploads all lights to the GPU. */
     void updateLightBuffer();
 
@@ -68,7 +156,8 @@ public:
     /** @return The list of all attached meshes. */
     const std::deque<std::shared_ptr<Mesh>>& getMeshes() const;
 
-    /** @brief Reorders the meshes according to their transparencies (transparent objects are rendered last). 
+    /** @brief Reorders the meshes according to their transparencies (transparent objects are rendered last).
+     * Meshes with the same material texture bitset are grouped to reduce the draws per MaterialProgram.
      * Should be called if any opacity issues occur.
      */
     void reorderMeshes();
@@ -78,9 +167,16 @@ private:
     std::deque<std::shared_ptr<Mesh>> m_meshes;
     std::shared_ptr<Camera> m_camera;
 
-    Buffer<glm::mat4> m_modelMatBuffer;
+    Buffer<InstanceData> m_instanceBuffer;
+    std::vector<InstanceData> m_instances;
+    std::vector<GLuint> m_materialIndices; // per mesh, written by updateMaterialBuffer
+    std::vector<Bounds> m_boundingBoxes;   // the uploaded bounds, to find the changed ones
     Buffer<Bounds> m_bBoxBuffer;
+    std::vector<Material> m_materials;     // the uploaded unique materials
+    std::unordered_map<Material, GLuint> m_materialLookup;
     Buffer<Material> m_materialBuffer;
+    TextureResidency m_textureResidency;
+    TextureStreaming m_textureStreaming;
 
     Buffer<GLuint> m_multiDrawIndexBuffer;
     Buffer<glm::vec4> m_multiDrawVertexBuffer;
@@ -88,12 +184,66 @@ private:
     Buffer<glm::vec2> m_multiDrawUVBuffer;
     VertexArray m_multiDrawVao;
 
+    // position-only stream for depth passes, shares the index buffer with m_multiDrawVao
+    Buffer<glm::vec3> m_depthVertexBuffer;
+    VertexArray m_depthVao;
+    GLsizei m_opaqueDrawCount = 0; // number of leading draws that need no alpha test
+
     Buffer<IndirectDrawCommand> m_indirectDrawBuffer;
 
+    // consecutive draws that share the material texture bitset and transparency, filled in updateMaterialBuffer
+    struct MaterialRange
+    {
+        GLuint materialFeatures;
+        GLsizei first;
+        GLsizei count;
+    };
+    std::vector<MaterialRange> m_materialRanges;
+
     Buffer<Light> m_lightBuffer;
-    Buffer<int> m_lightIndexBuffer;
+    // one light index per shadow map update, more updates per frame only make the ring wrap earlier
+    static constexpr int maxShadowMapsPerFrame = 64;
+    RingBuffer<int> m_lightIndexBuffer;
+
+    RingBuffer<GpuCamera> m_viewBuffer;
 
-    Program m_cullingProgram;
+    // indexed by CullingMode, the depth variants only request the textures of alpha tested draws
+    std::array<Program, 3> m_cullingPrograms;
+    std::array<Program, 3> m_depthCullingPrograms;
+
+    bool m_depthPrepass = false;
+    Program m_depthPrepassProgram;
+    Program m_multiViewDepthPrepassProgram;
 
     void updateMultiDrawBuffers();
+
+    /** @brief Appends the geometry and the draw command of one mesh to the multi-draw buffers without touching the others. */
+    void appendMultiDrawBuffers(const Mesh& mesh);
+
+    /** @brief Points the vertex arrays to the current multi-draw buffers. */
+    void updateVertexArrays();
+
+    /** @brief Groups consecutive draws with the same material texture bitset and transparency. */
+    void updateMaterialRanges();
+
+    /** @brief Passes the textures of every unique material to the residency manager and the texture streaming. */
+    void updateMaterialTextures();
+
+    using ProgramSelector = std::function<const Program&(GLuint materialFeatures)>;
+
+    /** @brief Shared implementation of both Scene::render overloads. */
+    void renderWithPrograms(const ProgramSelector& selectProgram, bool overwriteCameraBuffer, CullingMode cullingMode) const;
+
+    /** @brief Draws the draws [first, first + count) with the program selected for their material ranges.
+     * Consecutive ranges that use the same program are drawn with a single multi-draw.
+     */
+    void drawShaded(const ProgramSelector& selectProgram, GLsizei first, GLsizei count) const;
+
+    /** @brief Binds all scene buffers and runs the culling pass that fills the indirect draw buffer.
+     * @param depthOnly If true, only the materials of alpha tested draws are marked as used (see TextureResidency).
+     */
+    void cull(bool overwriteCameraBuffer, CullingMode cullingMode, bool depthOnly) const;
+
+    /** @brief Draws the indirect commands [first, first + count) with the given vertex array. */
+    void drawIndirect(const VertexArray& vao, GLsizei first, GLsizei count) const;
 };
\ No newline at end of file
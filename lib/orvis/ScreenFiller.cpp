@@ -1,4 +1,5 @@
 #include "ScreenFiller.hpp"
+#include "GlState.hpp"
 
 ScreenFiller::ScreenFiller(const std::shared_ptr<Shader>& fragmentShader, const std::shared_ptr<Camera>& camera) : m_camera(camera)
 {
@@ -12,12 +13,13 @@ ScreenFiller::ScreenFiller(const std::shared_ptr<Shader>& fragmentShader, const
 void ScreenFiller::render() const
 {
     m_camera->uploadToGpu();
-    glDepthMask(GL_FALSE);
+    const bool depthMask = GlState::get().getDepthMask();
+    GlState::get().setDepthMask(false);
     glDisable(GL_CULL_FACE);
     m_vao.bind();
     m_shaderProgram.use();
     glDrawArrays(GL_TRIANGLES, 0, 3);
-    glDepthMask(GL_TRUE);
+    GlState::get().setDepthMask(depthMask);
     glEnable(GL_CULL_FACE);
 }
 
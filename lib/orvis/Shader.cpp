@@ -1,4 +1,5 @@
 #include "Shader.hpp"
+#include "GlState.hpp"
 #include <algorithm>
 #include <fstream>
 #include <iostream>
@@ -311,7 +312,7 @@ void Program::use() const
 {
     if(!m_linked)
         link() ? 0 : throw std::runtime_error("Failed to link program!");
-    glUseProgram(*m_handle);
+    GlState::get().useProgram(*m_handle);
 }
 GLprogram Program::id() const { return m_handle; }
 bool   Program::reload(bool checkStatus)
@@ -1,9 +1,11 @@
 #include "Texture.hpp"
 
+#include <cassert>
+#include <mutex>
 #include "Util.hpp"
 #include "stb/stb_image.h"
 
-Sampler::Sampler() : m_samplerId(glCreateSamplerRAII())
+Sampler::Sampler()
 {
     // Set some default parameters for the sampler
     set(GL_TEXTURE_CUBE_MAP_SEAMLESS, true);
@@ -14,69 +16,62 @@ Sampler::Sampler() : m_samplerId(glCreateSamplerRAII())
     set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     set(GL_TEXTURE_MAX_ANISOTROPY_EXT, 16.f);
 }
-Sampler::~Sampler()
+
+void Sampler::set(GLenum texParam, int value)
 {
-	// done by RAII
+    m_samplerParams[texParam] = value;
+    m_samplerId.reset();
 }
-
-Sampler::Sampler(const Sampler& other) : m_samplerId(glCreateSamplerRAII())
+void Sampler::set(GLenum texParam, float value)
 {
-    for (const auto& var : other.m_samplerParams)
-    {
-        if (std::holds_alternative<int>(var.second))
-            set(var.first, std::get<int>(var.second));
-        else if (std::holds_alternative<float>(var.second))
-            set(var.first, std::get<float>(var.second));
-        else if (std::holds_alternative<GLenum>(var.second))
-            set(var.first, std::get<GLenum>(var.second));
-    }
+    m_samplerParams[texParam] = value;
+    m_samplerId.reset();
+}
+void Sampler::set(GLenum texParam, GLenum value)
+{
+    m_samplerParams[texParam] = value;
+    m_samplerId.reset();
 }
 
-Sampler::Sampler(Sampler&& other) noexcept
+GLsampler Sampler::id() const
 {
-    m_samplerId = std::move(other.m_samplerId);
-    m_samplerParams = std::move(other.m_samplerParams);
+    if (!m_samplerId)
+        m_samplerId = getCachedSampler(m_samplerParams);
+    return m_samplerId;
 }
 
-Sampler& Sampler::operator=(const Sampler& other)
+GLsampler Sampler::getCachedSampler(const Parameters& parameters)
 {
-	m_samplerId.reset();
-	m_samplerId = glCreateSamplerRAII();
+    // sampler objects are shared between contexts, so the upload thread uses the same cache
+    static std::mutex mutex;
+    static std::map<Parameters, std::weak_ptr<GlPtr<deleteSampler>>> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& cached = cache[parameters];
+    if (GLsampler sampler = cached.lock())
+        return sampler;
 
-    for (const auto& var : other.m_samplerParams)
+    // a sampler is only created on a miss, so sweeping the entries of deleted samplers here keeps the cache small
+    for (auto it = cache.begin(); it != cache.end();)
     {
-        if (std::holds_alternative<int>(var.second))
-            set(var.first, std::get<int>(var.second));
-        else if (std::holds_alternative<float>(var.second))
-            set(var.first, std::get<float>(var.second));
-        else if (std::holds_alternative<GLenum>(var.second))
-            set(var.first, std::get<GLenum>(var.second));
+        if (it->second.expired() && &it->second != &cached)
+            it = cache.erase(it);
+        else
+            ++it;
     }
-    return *this;
-}
 
-Sampler& Sampler::operator=(Sampler&& other) noexcept
-{
-	m_samplerId.reset();
-    m_samplerId = std::move(other.m_samplerId);
-    m_samplerParams = std::move(other.m_samplerParams);
-    return *this;
-}
-
-void Sampler::set(GLenum texParam, int value)
-{
-    m_samplerParams[texParam] = value;
-    glSamplerParameteri(*m_samplerId, texParam, value);
-}
-void Sampler::set(GLenum texParam, float value)
-{
-    m_samplerParams[texParam] = value;
-    glSamplerParameterf(*m_samplerId, texParam, value);
-}
-void Sampler::set(GLenum texParam, GLenum value)
-{
-    m_samplerParams[texParam] = value;
-    glSamplerParametere(*m_samplerId, texParam, value);
+    GLsampler sampler = glCreateSamplerRAII();
+    for (const auto& [texParam, value] : parameters)
+    {
+        if (std::holds_alternative<int>(value))
+            glSamplerParameteri(*sampler, texParam, std::get<int>(value));
+        else if (std::holds_alternative<float>(value))
+            glSamplerParameterf(*sampler, texParam, std::get<float>(value));
+        else if (std::holds_alternative<GLenum>(value))
+            glSamplerParametere(*sampler, texParam, std::get<GLenum>(value));
+    }
+    cached = sampler;
+    return sampler;
 }
 
 Texture::Texture(GLenum target)
@@ -118,28 +113,7 @@ Texture::Texture(const std::filesystem::path& filename, unsigned int channels, i
 {
     const bool isHdr = stbi_is_hdr(filename.string().c_str());
 
-    GLenum format, internalFormat;
-    switch (channels)
-    {
-    case 1:
-        format = GL_RED;
-        internalFormat = GL_R16F;// isHdr ? GL_R16F : GL_R8;
-        break;
-    case 2:
-        format = GL_RG;
-        internalFormat = GL_RG16F;// isHdr ? GL_RG16F : GL_RG8;
-        break;
-    case 3:
-        format = GL_RGB;
-        internalFormat = GL_RGB16F;// isHdr ? GL_RGB16F : GL_RGB8;
-        break;
-    case 4:
-        format = GL_RGBA;
-        internalFormat = GL_RGBA16F;// isHdr ? GL_RGBA16F : GL_RGBA8;
-        break;
-    default:
-        throw std::runtime_error("Tried to load texture with invalid number of channels (" + std::to_string(channels) + ")");
-    }
+    const auto [format, internalFormat] = getFileFormats(channels);
 
     int imageWidth, imageHeight, numChannels;
 
@@ -168,6 +142,8 @@ Texture::Texture(const std::filesystem::path& filename, unsigned int channels, i
 
     generateMipmaps();
     generateHandle();
+    // resize replaced the whole texture, so the source is set last
+    setSourceFile(filename, channels);
 
     util::getGlError(__LINE__, __FUNCTION__);
 }
@@ -263,6 +239,8 @@ Texture::Texture(const Texture& other)
     m_levels = other.m_levels;
     m_samples = other.m_samples;
     m_overrideSampler = other.m_overrideSampler;
+    m_sourceFile = other.m_sourceFile;
+    m_sourceChannels = other.m_sourceChannels;
 
     switch (m_target)
     {
@@ -320,8 +298,11 @@ Texture::Texture(Texture&& other) noexcept
     m_levels = other.m_levels;
     m_samples = other.m_samples;
     m_overrideSampler = std::move(other.m_overrideSampler);
+    m_sourceFile = std::move(other.m_sourceFile);
+    m_sourceChannels = other.m_sourceChannels;
     m_hasMipmaps = other.m_hasMipmaps;
     m_imageHandleTree = std::move(other.m_imageHandleTree);
+    m_samplerHandles = std::move(other.m_samplerHandles);
     m_textureHandle = other.m_textureHandle;
 }
 
@@ -337,8 +318,11 @@ Texture& Texture::operator=(Texture&& other) noexcept
     m_levels = other.m_levels;
     m_samples = other.m_samples;
     m_overrideSampler = std::move(other.m_overrideSampler);
+    m_sourceFile = std::move(other.m_sourceFile);
+    m_sourceChannels = other.m_sourceChannels;
     m_hasMipmaps = other.m_hasMipmaps;
     m_imageHandleTree = std::move(other.m_imageHandleTree);
+    m_samplerHandles = std::move(other.m_samplerHandles);
     m_textureHandle = other.m_textureHandle;
     return *this;
 }
@@ -355,6 +339,10 @@ Texture& Texture::operator=(const Texture& other)
     m_levels = other.m_levels;
     m_samples = other.m_samples;
     m_overrideSampler = other.m_overrideSampler;
+    m_sourceFile = other.m_sourceFile;
+    m_sourceChannels = other.m_sourceChannels;
+    m_samplerHandles.clear();
+    m_textureHandle = 0;
 
     switch (m_target)
     {
@@ -417,9 +405,7 @@ void Texture::set(GLenum texParam, int value)
 {
     if (m_overrideSampler)
         return;
-    Sampler new_sampler = m_defaultSampler;
-    new_sampler.set(texParam, value);
-    m_defaultSampler = std::move(new_sampler);
+    m_defaultSampler.set(texParam, value);
     generateHandle();
 }
 
@@ -427,9 +413,7 @@ void Texture::set(GLenum texParam, float value)
 {
     if (m_overrideSampler)
         return;
-    Sampler new_sampler = m_defaultSampler;
-    new_sampler.set(texParam, value);
-    m_defaultSampler = std::move(new_sampler);
+    m_defaultSampler.set(texParam, value);
     generateHandle();
 }
 
@@ -437,9 +421,7 @@ void Texture::set(GLenum texParam, GLenum value)
 {
     if (m_overrideSampler)
         return;
-    Sampler new_sampler = m_defaultSampler;
-    new_sampler.set(texParam, value);
-    m_defaultSampler = std::move(new_sampler);
+    m_defaultSampler.set(texParam, value);
     generateHandle();
 }
 
@@ -464,10 +446,8 @@ void Texture::set(const TexParamMap& parameters)
         Sampler & m_sampler;
         GLenum   m_tparam;
     };
-    Sampler new_sampler = m_defaultSampler;
     for (const auto& p : parameters)
-        std::visit(ParamVisitor(p.first, new_sampler), p.second);
-    m_defaultSampler = std::move(new_sampler);
+        std::visit(ParamVisitor(p.first, m_defaultSampler), p.second);
     generateHandle();
 }
 
@@ -523,6 +503,29 @@ void Texture::generateMipmaps() const
     m_hasMipmaps = true;
 }
 
+Texture Texture::copyLevels(int baseLevel) const
+{
+    assert(m_target == GL_TEXTURE_2D && baseLevel >= 0 && baseLevel < m_levels && "Invalid level range!");
+
+    const glm::ivec2 size = glm::max(glm::ivec2(m_size) >> baseLevel, glm::ivec2(1));
+    Texture copy(GL_TEXTURE_2D, m_format, size, m_levels - baseLevel);
+    for (int level = 0; level < copy.m_levels; ++level)
+    {
+        const glm::ivec2 levelSize = glm::max(size >> level, glm::ivec2(1));
+        glCopyImageSubData(*m_textureId, GL_TEXTURE_2D, baseLevel + level, 0, 0, 0,
+            *copy.m_textureId, GL_TEXTURE_2D, level, 0, 0, 0, levelSize.x, levelSize.y, 1);
+    }
+
+    copy.m_defaultSampler = m_defaultSampler;
+    copy.m_overrideSampler = m_overrideSampler;
+    copy.m_hasMipmaps = m_hasMipmaps;
+    copy.setSourceFile(m_sourceFile, m_sourceChannels);
+    copy.generateHandle();
+
+    util::getGlError(__LINE__, __FUNCTION__);
+    return copy;
+}
+
 void Texture::bind(std::variant<GLuint, TextureBinding> binding) const
 {
     const GLuint b = std::holds_alternative<GLuint>(binding) ? std::get<GLuint>(binding) : static_cast<GLuint>(std::get<TextureBinding>(binding));
@@ -530,20 +533,19 @@ void Texture::bind(std::variant<GLuint, TextureBinding> binding) const
     glBindTextureUnit(b, *m_textureId);
 }
 
-void Texture::bindImage(std::variant<GLuint, TextureBinding> binding) const { bindImage(binding, GL_READ_WRITE, m_format); }
-void Texture::bindImage(std::variant<GLuint, TextureBinding> binding, GLenum access, GLenum format) const
+void Texture::bindImage(std::variant<GLuint, TextureBinding, ImageBinding> binding) const { bindImage(binding, GL_READ_WRITE, m_format); }
+void Texture::bindImage(std::variant<GLuint, TextureBinding, ImageBinding> binding, GLenum access, GLenum format) const
 {
     bindImage(binding, 0, true, 0, access, format);
 }
-void Texture::bindImage(std::variant<GLuint, TextureBinding> binding, int level, bool layered, int layer, GLenum access,
+void Texture::bindImage(std::variant<GLuint, TextureBinding, ImageBinding> binding, int level, bool layered, int layer, GLenum access,
     GLenum format) const
 {
-    const GLuint b = std::holds_alternative<GLuint>(binding) ? std::get<GLuint>(binding) : static_cast<GLuint>(std::get<TextureBinding>(binding));
+    const GLuint b = std::visit([](auto b) { return static_cast<GLuint>(b); }, binding);
     glBindImageTexture(b, *m_textureId, level, layered, layer, access, format);
 }
 
 GLtexture Texture::id() const { return m_textureId; }
-GLsampler Sampler::id() const { return m_samplerId; }
 void   Texture::clear(GLint level, GLenum format, GLenum type, const void* data) const
 {
     glClearTexImage(*m_textureId, level, format, type, data);
@@ -555,17 +557,24 @@ void Texture::clear(GLenum format, GLenum type, const void* data) const
 
 void Texture::generateHandle()
 {
+    // a texture/sampler pair always has the same handle, so switching back to a sampler reuses it
+    const GLsampler samplerId = sampler().id();
+    auto handle = m_samplerHandles.find(*samplerId);
+    if (handle == m_samplerHandles.end())
+    {
+        const GLuint64 newHandle = glGetTextureSamplerHandleARB(*m_textureId, *samplerId);
+        util::getGlError(__LINE__, __FUNCTION__);
+        handle = m_samplerHandles.emplace(*samplerId, std::make_pair(samplerId, newHandle)).first;
+    }
+    if (handle->second.second == m_textureHandle)
+        return;
+
     if (m_textureHandle && glIsTextureHandleResidentARB(m_textureHandle))
         glMakeTextureHandleNonResidentARB(m_textureHandle);
 
-    //if(glIsTextureHandleResidentARB(m_textureHandle))
-    //    glMakeTextureHandleNonResidentARB(m_textureHandle);
-
     util::getGlError(__LINE__, __FUNCTION__);
 
-    m_textureHandle = glGetTextureSamplerHandleARB(*m_textureId, *(sampler().id()));
-
-    util::getGlError(__LINE__, __FUNCTION__);
+    m_textureHandle = handle->second.second;
 
     if (!glIsTextureHandleResidentARB(m_textureHandle))
         glMakeTextureHandleResidentARB(m_textureHandle);
@@ -574,6 +583,40 @@ void Texture::generateHandle()
 }
 GLuint64 Texture::handle() const { return m_textureHandle; }
 
+void Texture::makeResident() const
+{
+    if (m_textureHandle && !glIsTextureHandleResidentARB(m_textureHandle))
+        glMakeTextureHandleResidentARB(m_textureHandle);
+}
+
+void Texture::makeNonResident() const
+{
+    if (m_textureHandle && glIsTextureHandleResidentARB(m_textureHandle))
+        glMakeTextureHandleNonResidentARB(m_textureHandle);
+}
+
+bool Texture::isResident() const
+{
+    return m_textureHandle && glIsTextureHandleResidentARB(m_textureHandle);
+}
+
+std::pair<GLenum, GLenum> Texture::getFileFormats(unsigned int channels)
+{
+    switch (channels)
+    {
+    case 1:
+        return { GL_RED, GL_R16F };// isHdr ? GL_R16F : GL_R8;
+    case 2:
+        return { GL_RG, GL_RG16F };// isHdr ? GL_RG16F : GL_RG8;
+    case 3:
+        return { GL_RGB, GL_RGB16F };// isHdr ? GL_RGB16F : GL_RGB8;
+    case 4:
+        return { GL_RGBA, GL_RGBA16F };// isHdr ? GL_RGBA16F : GL_RGBA8;
+    default:
+        throw std::runtime_error("Tried to load texture with invalid number of channels (" + std::to_string(channels) + ")");
+    }
+}
+
 GLuint64 Texture::imageHandle(int level, bool layered, int layer, GLenum access, GLenum format)
 {
 
@@ -605,6 +648,63 @@ glm::ivec3 Texture::getSize() const
     return m_size;
 }
 
+int Texture::getLevels() const
+{
+    return m_levels;
+}
+
+void Texture::setSourceFile(const std::filesystem::path& filename, unsigned int channels)
+{
+    m_sourceFile = filename;
+    m_sourceChannels = channels;
+}
+
+const std::filesystem::path& Texture::getSourceFile() const
+{
+    return m_sourceFile;
+}
+
+unsigned int Texture::getSourceChannels() const
+{
+    return m_sourceChannels;
+}
+
+size_t Texture::getMemorySize() const
+{
+    size_t texelSize;
+    switch (m_format)
+    {
+    case GL_R8:
+        texelSize = 1;
+        break;
+    case GL_R16F:
+    case GL_RG8:
+    case GL_DEPTH_COMPONENT16:
+        texelSize = 2;
+        break;
+    case GL_RGBA16F:
+    case GL_RGB16F: // padded to four channels by most drivers
+    case GL_RG32F:
+        texelSize = 8;
+        break;
+    case GL_RGBA32F:
+    case GL_RGB32F:
+        texelSize = 16;
+        break;
+    default:
+        texelSize = 4;
+        break;
+    }
+
+    size_t size = 0;
+    for (int level = 0; level < std::max(m_levels, 1); ++level)
+    {
+        const glm::ivec3 levelSize = glm::max(m_size >> level, glm::ivec3(1));
+        size += size_t(levelSize.x) * levelSize.y * levelSize.z;
+    }
+    return size * texelSize * std::max(static_cast<int>(m_samples), 1);
+}
+
 void Texture::resize(GLenum target, GLenum format, glm::ivec2 size, Samples samples,
     bool fixedSampleLocations)
 {
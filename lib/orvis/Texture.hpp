@@ -2,6 +2,8 @@
 
 #include <glbinding/gl/gl.h>
 #include <glm/glm.hpp>
+#include <filesystem>
+#include <map>
 #include <memory>
 #include <unordered_map>
 #include <variant>
@@ -26,30 +28,33 @@ enum class Samples
 /**
  * @brief An OpenGL sampler object holding texture sampling data. This is to prohibit all the
  * glSetTextureParameter calls which may or may not work.
+ * @details Samplers with the same parameters share one sampler object from a process wide cache, it is created on the
+ * first call of Sampler::id. Constructing, copying and setting parameters does not call OpenGL.
  */
 class Sampler
 {
 public:
+    /** @brief Creates a sampler with trilinear, anisotropic filtering and mirrored repeat wrapping. */
     Sampler();
-    ~Sampler();
-    Sampler(const Sampler& other);
-    Sampler(Sampler&& other) noexcept;
-    Sampler& operator=(const Sampler& other);
-    Sampler& operator=(Sampler&& other) noexcept;
 
-    /** @brief Sets a sampler parameter via glSamplerParameteri. */
+    /** @brief Sets a sampler parameter, glSamplerParameteri is called when the sampler object is created. */
     void set(GLenum texParam, int value);
-    /** @brief Sets a sampler parameter via glSamplerParameterf. */
+    /** @brief Sets a sampler parameter, glSamplerParameterf is called when the sampler object is created. */
     void set(GLenum texParam, float value);
-    /** @brief Sets a sampler parameter via glSamplerParametere. */
+    /** @brief Sets a sampler parameter, glSamplerParametere is called when the sampler object is created. */
     void set(GLenum texParam, GLenum value);
 
-    /** @return The sampler object ID. */
+    /** @return The sampler object ID, shared by all samplers with the same parameters. */
     GLsampler id() const;
 
 private:
-    GLsampler													 m_samplerId;
-    std::unordered_map<GLenum, std::variant<int, float, GLenum>> m_samplerParams;
+    using Parameters = std::map<GLenum, std::variant<int, float, GLenum>>;
+
+    /** @return The cached sampler object for the parameters, created if there is none. Thread-safe. */
+    static GLsampler getCachedSampler(const Parameters& parameters);
+
+    Parameters        m_samplerParams;
+    mutable GLsampler m_samplerId;  // resolved lazily, reset by set
 };
 
 /**
@@ -319,6 +324,14 @@ public:
      */
     void generateMipmaps() const;
 
+    /**
+     * @brief Creates a 2D texture from the levels of this texture, copied on the GPU. The sampler and the source file
+     * are taken over.
+     * @param baseLevel The level that becomes level 0 of the copy.
+     * @return The copy with getLevels() - baseLevel levels.
+     */
+    Texture copyLevels(int baseLevel) const;
+
     /**
      * @brief Binds the texture to the given binding point.
      * @param binding The binding point which can then be accessed by a GLSL layout binding
@@ -331,7 +344,7 @@ public:
      * image with its preset internal format.
      * @param binding The image binding.
      */
-    void bindImage(std::variant<GLuint, TextureBinding> binding) const;
+    void bindImage(std::variant<GLuint, TextureBinding, ImageBinding> binding) const;
 
     /**
      * @brief Binds the first mipmap level of the texture to as a non-layered image.
@@ -339,7 +352,7 @@ public:
      * @param access The access flag for the image.
      * @param format The binding format (e.g. GL_RGBA32F for rgba32f)
      */
-    void bindImage(std::variant<GLuint, TextureBinding> binding, GLenum access, GLenum format) const;
+    void bindImage(std::variant<GLuint, TextureBinding, ImageBinding> binding, GLenum access, GLenum format) const;
 
     /**
      * @brief Binds the texture as an image.
@@ -350,7 +363,7 @@ public:
      * @param access The access flag for the image.
      * @param format The binding format (e.g. GL_RGBA32F for rgba32f)
      */
-    void bindImage(std::variant<GLuint, TextureBinding> binding, int level, bool layered, int layer, GLenum access,
+    void bindImage(std::variant<GLuint, TextureBinding, ImageBinding> binding, int level, bool layered, int layer, GLenum access,
                    GLenum format) const;
 
     /** @return The texture id */
@@ -399,6 +412,26 @@ public:
      */
     GLuint64 handle() const;
 
+    /**
+     * @brief Makes the bindless texture handle resident in the current context.
+     * Residency is per context, textures created on a shared context (e.g. by the UploadService) have to call this
+     * on the render thread before their handle is used.
+     */
+    void makeResident() const;
+
+    /** @brief Makes the bindless texture handle non-resident in the current context, e.g. to free video memory. */
+    void makeNonResident() const;
+
+    /** @return true if the bindless texture handle is resident in the current context. */
+    bool isResident() const;
+
+    /**
+     * @brief Gets the upload and internal format that Texture(const std::filesystem::path&, unsigned int, int) uses.
+     * @param channels The number of channels that are loaded from the file (1 to 4).
+     * @return The pixel format of the loaded data (e.g. GL_RGBA) and the internal texture format.
+     */
+    static std::pair<GLenum, GLenum> getFileFormats(unsigned int channels);
+
     /**
      * @brief Retrieves and stores the image handle for the texture part referenced by the given
      * parameters.
@@ -429,6 +462,27 @@ public:
      */
     glm::ivec3 getSize() const;
 
+    /** @return The number of mipmap levels of the texture. */
+    int getLevels() const;
+
+    /**
+     * @brief Sets the image file the levels of the texture can be decoded from again, e.g. by TextureStreaming.
+     * Texture(const std::filesystem::path&, unsigned int, int) sets it, code that changes the contents afterwards has
+     * to reset it to an empty path.
+     * @param filename The image file, empty if the contents can not be restored from a file.
+     * @param channels The number of channels the file was loaded with.
+     */
+    void setSourceFile(const std::filesystem::path& filename, unsigned int channels);
+
+    /** @return The image file the texture can be decoded from again, empty if there is none. */
+    const std::filesystem::path& getSourceFile() const;
+
+    /** @return The number of channels the source file was loaded with. */
+    unsigned int getSourceChannels() const;
+
+    /** @return An estimate of the video memory used by all levels, from the size and the internal format. */
+    size_t getMemorySize() const;
+
 private:
     template <typename T, typename N>
     using UMap       = std::unordered_map<T, N>;
@@ -449,6 +503,10 @@ private:
     mutable bool             m_hasMipmaps           = false;
     std::shared_ptr<Sampler> m_overrideSampler      = nullptr;
     Sampler                  m_defaultSampler;
+    std::filesystem::path    m_sourceFile;
+    unsigned int             m_sourceChannels       = 0;
+    // one bindless handle per sampler object, the sampler is kept so its name is not reused
+    std::unordered_map<GLuint, std::pair<GLsampler, GLuint64>> m_samplerHandles;
 };
 
 #include "Texture.inl"
@@ -41,7 +41,9 @@ std::vector<T> Texture::data(GLenum format, int level) const
         break;
     }
 
-    const glm::ivec3 dim = m_size;
+    // only the first two dimensions shrink for array and cube map levels
+    glm::ivec3 dim = m_size >> level;
+    dim = glm::max(m_target == GL_TEXTURE_3D ? dim : glm::ivec3(glm::ivec2(dim), m_size.z), glm::ivec3(1));
     std::vector<T>   pixels(dim.x * dim.y * dim.z * components);
     glGetTextureImage(*m_textureId,
         level,
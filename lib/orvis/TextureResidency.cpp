@@ -0,0 +1,238 @@
+#include "TextureResidency.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <imgui.h>
+
+TextureResidency::TextureResidency()
+    : m_residentBuffer(std::vector<GLuint>{ 1u }, GL_DYNAMIC_STORAGE_BIT)
+    , m_usageBuffer(std::vector<GLuint>{ 0u }, GL_DYNAMIC_STORAGE_BIT)
+{
+}
+
+void TextureResidency::setMaterials(const std::vector<std::vector<std::shared_ptr<Texture>>>& materialTextures)
+{
+    std::vector<TextureEntry> textures;
+    std::unordered_map<const Texture*, size_t> lookup;
+    m_materialTextures.assign(materialTextures.size(), {});
+    for (GLuint material = 0; material < static_cast<GLuint>(materialTextures.size()); ++material)
+    {
+        for (const auto& texture : materialTextures[material])
+        {
+            if (!texture || !texture->handle())
+                continue;
+
+            const auto [entry, inserted] = lookup.try_emplace(texture.get(), textures.size());
+            if (inserted)
+            {
+                TextureEntry newEntry;
+                newEntry.texture = texture;
+                newEntry.lastUse = m_frame;
+                newEntry.resident = false;
+                textures.push_back(std::move(newEntry));
+            }
+            textures[entry->second].materials.push_back(material);
+            m_materialTextures[material].push_back(entry->second);
+        }
+    }
+
+    // textures that are not referenced anymore are dropped, the others start resident
+    m_textures = std::move(textures);
+    m_residentCount = 0;
+    for (auto& entry : m_textures)
+        makeResident(entry);
+
+    const size_t count = std::max<size_t>(materialTextures.size(), 1);
+    m_materialResident.assign(count, 1u);
+    m_residentBuffer = Buffer<GLuint>(m_materialResident, GL_DYNAMIC_STORAGE_BIT);
+    m_usageBuffer = Buffer<GLuint>(std::vector<GLuint>(count, 0u), GL_DYNAMIC_STORAGE_BIT);
+
+    // pending readbacks refer to the old material indices and are dropped
+    m_usageReadback = ReadbackBuffer<GLuint>(static_cast<GLsizeiptr>(materialTextures.size()));
+}
+
+void TextureResidency::setBudget(size_t bytes)
+{
+    m_budget = bytes;
+    if (m_budget != 0)
+        return;
+
+    // unlimited, bring everything back
+    std::vector<GLuint> materials(m_materialTextures.size());
+    std::iota(materials.begin(), materials.end(), 0u);
+    for (auto& entry : m_textures)
+        makeResident(entry);
+    updateMaterialFlags(materials);
+}
+
+size_t TextureResidency::getBudget() const
+{
+    return m_budget;
+}
+
+void TextureResidency::bind() const
+{
+    m_residentBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::materialResidency);
+    m_usageBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::materialUsage);
+}
+
+bool TextureResidency::readUsage()
+{
+    return m_usageReadback.read([this](const GLuint* usage, uint64_t frame)
+    {
+        for (size_t material = 0; material < m_materialTextures.size(); ++material)
+        {
+            if (!usage[material])
+                continue;
+            for (const size_t texture : m_materialTextures[material])
+                m_textures[texture].lastUse = std::max(m_textures[texture].lastUse, frame);
+        }
+    }) > 0;
+}
+
+void TextureResidency::requestUsage()
+{
+    // if all readbacks are in flight, the usage keeps accumulating until one is free
+    if (!m_usageReadback.request(m_usageBuffer, m_frame))
+        return;
+
+    const GLuint zero = 0u;
+    glClearNamedBufferData(*m_usageBuffer.id(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+}
+
+void TextureResidency::update()
+{
+    ++m_frame;
+    if (m_budget == 0 || m_materialTextures.empty())
+        return;
+
+    const bool read = readUsage();
+    requestUsage();
+    if (!read)
+        return;
+
+    // newest frame that was read back, its textures are in view and must not be evicted
+    const uint64_t newest = std::max_element(m_textures.begin(), m_textures.end(),
+        [](const TextureEntry& a, const TextureEntry& b) { return a.lastUse < b.lastUse; })->lastUse;
+
+    std::vector<GLuint> changedMaterials;
+    for (auto& entry : m_textures)
+    {
+        if (!entry.resident && entry.lastUse == newest)
+        {
+            makeResident(entry);
+            changedMaterials.insert(changedMaterials.end(), entry.materials.begin(), entry.materials.end());
+        }
+    }
+
+    std::vector<size_t> evictionOrder;
+    for (size_t i = 0; i < m_textures.size(); ++i)
+    {
+        if (m_textures[i].resident && m_textures[i].lastUse < newest)
+            evictionOrder.push_back(i);
+    }
+    std::sort(evictionOrder.begin(), evictionOrder.end(),
+        [this](size_t a, size_t b) { return m_textures[a].lastUse < m_textures[b].lastUse; });
+
+    std::vector<size_t> evicted;
+    size_t residentSize = getResidentSize();
+    for (const size_t i : evictionOrder)
+    {
+        if (residentSize <= m_budget)
+            break;
+        residentSize -= m_textures[i].texture->getMemorySize();
+        m_textures[i].resident = false;
+        evicted.push_back(i);
+        changedMaterials.insert(changedMaterials.end(), m_textures[i].materials.begin(), m_textures[i].materials.end());
+    }
+
+    // the shaders have to fall back to the placeholders before the handles become non-resident
+    updateMaterialFlags(changedMaterials);
+    for (const size_t i : evicted)
+    {
+        m_textures[i].resident = true;
+        makeNonResident(m_textures[i]);
+    }
+}
+
+void TextureResidency::makeResident(TextureEntry& entry)
+{
+    if (entry.resident)
+        return;
+    entry.texture->makeResident();
+    entry.resident = true;
+    ++m_residentCount;
+}
+
+void TextureResidency::makeNonResident(TextureEntry& entry)
+{
+    if (!entry.resident)
+        return;
+    entry.texture->makeNonResident();
+    entry.resident = false;
+    --m_residentCount;
+}
+
+void TextureResidency::updateMaterialFlags(const std::vector<GLuint>& materials)
+{
+    std::vector<GLsizeiptr> changed;
+    for (const GLuint material : materials)
+    {
+        const bool resident = std::all_of(m_materialTextures[material].begin(), m_materialTextures[material].end(),
+            [this](size_t texture) { return m_textures[texture].resident; });
+        if (m_materialResident[material] != static_cast<GLuint>(resident))
+        {
+            m_materialResident[material] = resident;
+            changed.push_back(material);
+        }
+    }
+
+    if (changed.empty())
+        return;
+    std::sort(changed.begin(), changed.end());
+    m_residentBuffer.assignDirty(m_materialResident, changed);
+}
+
+size_t TextureResidency::getResidentSize() const
+{
+    size_t size = 0;
+    for (const auto& entry : m_textures)
+        size += entry.resident ? entry.texture->getMemorySize() : 0;
+    return size;
+}
+
+size_t TextureResidency::getResidentCount() const
+{
+    return m_residentCount;
+}
+
+size_t TextureResidency::getTextureCount() const
+{
+    return m_textures.size();
+}
+
+bool TextureResidency::drawGuiWindow()
+{
+    ImGui::SetNextWindowSize(ImVec2(300, 120), ImGuiSetCond_FirstUseEver);
+    ImGui::Begin("Texture Residency");
+    const bool changed = drawGuiContent();
+    ImGui::End();
+    return changed;
+}
+
+bool TextureResidency::drawGuiContent()
+{
+    ImGui::PushID(this);
+
+    int budget = static_cast<int>(m_budget / (1024 * 1024));
+    const bool changed = ImGui::DragInt("Budget (MB, 0 = unlimited)", &budget, 8.0f, 0, 1 << 16);
+    if (changed)
+        setBudget(static_cast<size_t>(budget) * 1024 * 1024);
+
+    ImGui::Text("%zu of %zu textures resident", m_residentCount, m_textures.size());
+    ImGui::Text("%.1f MB resident", getResidentSize() / (1024.0 * 1024.0));
+
+    ImGui::PopID();
+    return changed;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <glbinding/gl/gl.h>
+#include "Buffer.hpp"
+#include "ReadbackBuffer.hpp"
+#include "Texture.hpp"
+
+using namespace gl;
+
+/**
+ * @brief Keeps the bindless handles of the visible materials resident within a video memory budget.
+ * @details The culling pass of Scene::render marks the materials of all visible draws in a usage buffer, the one of
+ * Scene::renderDepth only those of alpha tested draws. TextureResidency::update reads the usage back a few frames later
+ * (without waiting for the GPU), makes the textures of the used materials resident and evicts the least recently used
+ * textures until the resident set fits into the budget. Draws are never skipped, materials that are not resident are
+ * shaded with placeholder values (see material.glsl) until their textures are resident again, usually one or two frames
+ * after they became visible. A budget of 0 keeps all textures resident and disables the readback.
+ */
+class TextureResidency
+{
+public:
+    TextureResidency();
+
+    TextureResidency(const TextureResidency& other) = delete;
+    TextureResidency& operator=(const TextureResidency& other) = delete;
+
+    /**
+     * @brief Sets the textures that are referenced by each material. Textures are identified by their pointer, so
+     * textures shared by several materials are only counted once. All textures are made resident.
+     * @param materialTextures The textures of material i at index i, in the order of the material buffer.
+     */
+    void setMaterials(const std::vector<std::vector<std::shared_ptr<Texture>>>& materialTextures);
+
+    /** @brief Sets the budget for the resident textures in bytes (see Texture::getMemorySize), 0 disables eviction. */
+    void setBudget(size_t bytes);
+    size_t getBudget() const;
+
+    /** @brief Binds the residency flags for the material shaders and the usage buffer for the culling pass. */
+    void bind() const;
+
+    /** @brief Reads back the usage of finished frames and updates the resident set. Call once per frame. */
+    void update();
+
+    /** @return The estimated size of all resident textures in bytes, streamed textures count with their current size. */
+    size_t getResidentSize() const;
+
+    /** @return The number of resident textures. */
+    size_t getResidentCount() const;
+
+    /** @return The number of textures referenced by any material. */
+    size_t getTextureCount() const;
+
+    /**
+    * @brief Draws a ImGui-window with the budget and the size of the resident set.
+    * @return true if the budget was changed.
+    */
+    bool drawGuiWindow();
+
+    /**
+    * @brief Draws the ImGui-content with the budget and the size of the resident set.
+    * @return true if the budget was changed.
+    */
+    bool drawGuiContent();
+
+private:
+    struct TextureEntry
+    {
+        std::shared_ptr<Texture> texture;
+        uint64_t lastUse = 0;   // the frame in which a material of the texture was visible the last time
+        bool resident = true;
+        std::vector<GLuint> materials;
+    };
+
+    /** @brief Reads the usage of all finished readbacks, returns false if none was ready. */
+    bool readUsage();
+
+    /** @brief Copies the usage flags to the readback buffer and clears them, unless all readbacks are in flight. */
+    void requestUsage();
+
+    void makeResident(TextureEntry& entry);
+    void makeNonResident(TextureEntry& entry);
+
+    /** @brief Recomputes the residency flags of the given materials, a material is resident if all its textures are. */
+    void updateMaterialFlags(const std::vector<GLuint>& materials);
+
+    std::vector<TextureEntry> m_textures;
+    std::vector<std::vector<size_t>> m_materialTextures; // indices into m_textures
+    std::vector<GLuint> m_materialResident;
+
+    Buffer<GLuint> m_residentBuffer;
+    Buffer<GLuint> m_usageBuffer;
+    ReadbackBuffer<GLuint> m_usageReadback;
+
+    uint64_t m_frame = 1;
+    size_t m_budget = 0;
+    size_t m_residentCount = 0;
+};
@@ -0,0 +1,308 @@
+#include "TextureStreaming.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <imgui.h>
+#include "UploadService.hpp"
+#include "stb/stb_image.h"
+
+TextureStreaming::TextureStreaming()
+    : m_feedbackBuffer(std::vector<GLuint>{ 0u }, GL_DYNAMIC_STORAGE_BIT)
+    , m_feedbackParameterBuffer(std::vector<glm::uvec4>{ glm::uvec4(1u, 0u, 0u, 0u) }, GL_DYNAMIC_STORAGE_BIT)
+    , m_finished(std::make_shared<std::vector<FinishedUpload>>())
+{
+}
+
+void TextureStreaming::setMaterials(const std::vector<std::vector<std::shared_ptr<Texture>>>& materialTextures)
+{
+    // keep the state of known textures, their fine levels may be missing right now
+    std::unordered_map<const Texture*, StreamedTexture> known;
+    for (auto& entry : m_textures)
+    {
+        entry.materials.clear();
+        known.emplace(entry.texture.get(), std::move(entry));
+    }
+
+    std::vector<StreamedTexture> textures;
+    std::unordered_map<const Texture*, size_t> lookup;
+    m_materialTextures.assign(materialTextures.size(), {});
+    for (GLuint material = 0; material < static_cast<GLuint>(materialTextures.size()); ++material)
+    {
+        for (const auto& texture : materialTextures[material])
+        {
+            if (!texture || texture->getTarget() != GL_TEXTURE_2D || texture->getSourceFile().empty())
+                continue;
+
+            const auto [entry, inserted] = lookup.try_emplace(texture.get(), textures.size());
+            if (inserted)
+            {
+                const auto old = known.find(texture.get());
+                if (old != known.end())
+                {
+                    textures.push_back(std::move(old->second));
+                    known.erase(old);
+                }
+                else
+                {
+                    StreamedTexture newEntry;
+                    newEntry.texture = texture;
+                    newEntry.sourceFile = texture->getSourceFile();
+                    newEntry.channels = texture->getSourceChannels();
+                    newEntry.size = glm::ivec2(texture->getSize());
+
+                    // a texture that was streamed before may be missing its fine levels, the file has the full size
+                    int width, height, fileChannels;
+                    if (stbi_info(newEntry.sourceFile.string().c_str(), &width, &height, &fileChannels))
+                        newEntry.size = glm::ivec2(width, height);
+                    newEntry.levels = static_cast<int>(std::floor(std::log2(std::max(newEntry.size.x, newEntry.size.y)))) + 1;
+                    newEntry.baseLevel = std::max(newEntry.levels - texture->getLevels(), 0);
+
+                    // new textures start with the coarse levels only, TextureStreaming::update drops the others
+                    newEntry.requestedLevel = m_enabled ? getMinLevel(newEntry) : 0;
+                    newEntry.lastRequest = m_frame;
+                    textures.push_back(std::move(newEntry));
+                }
+            }
+            textures[entry->second].materials.push_back(material);
+            m_materialTextures[material].push_back(entry->second);
+        }
+    }
+
+    m_textures = std::move(textures);
+
+    // textures of removed materials are not tracked anymore, so they have to be complete again
+    for (auto& [pointer, entry] : known)
+    {
+        if (entry.baseLevel != 0)
+            stream(entry, 0);
+    }
+
+    const size_t count = std::max<size_t>(materialTextures.size(), 1);
+    m_feedbackBuffer = Buffer<GLuint>(std::vector<GLuint>(count, 0u), GL_DYNAMIC_STORAGE_BIT);
+    m_feedbackReadback = ReadbackBuffer<GLuint>(static_cast<GLsizeiptr>(materialTextures.size()));
+}
+
+void TextureStreaming::setUploadService(UploadService* uploadService)
+{
+    m_uploadService = uploadService;
+}
+
+void TextureStreaming::setEnabled(bool enabled)
+{
+    if (enabled == m_enabled)
+        return;
+
+    m_enabled = enabled;
+    m_feedbackParameterBuffer.assign(glm::uvec4(enabled ? 1u : 0u, 0u, 0u, 0u));
+    for (auto& entry : m_textures)
+    {
+        entry.requestedLevel = enabled ? getMinLevel(entry) : 0;
+        entry.lastRequest = m_frame;
+    }
+}
+
+bool TextureStreaming::isEnabled() const
+{
+    return m_enabled;
+}
+
+void TextureStreaming::bind() const
+{
+    m_feedbackBuffer.bind(GL_SHADER_STORAGE_BUFFER, BufferBinding::materialFeedback);
+    m_feedbackParameterBuffer.bind(GL_UNIFORM_BUFFER, BufferBinding::materialFeedbackParameters);
+}
+
+int TextureStreaming::getMinLevel(const StreamedTexture& texture)
+{
+    const int largest = std::max(texture.size.x, texture.size.y);
+    const int level = static_cast<int>(std::floor(std::log2(largest))) - static_cast<int>(std::log2(minResolution));
+    return std::clamp(level, 0, texture.levels - 1);
+}
+
+size_t TextureStreaming::getLevelsSize(const StreamedTexture& texture, int baseLevel)
+{
+    // every level is a quarter of the one above, so scale the current size by the difference in levels
+    const int shift = 2 * (texture.baseLevel - baseLevel);
+    const size_t size = texture.texture->getMemorySize();
+    return shift >= 0 ? size << shift : size >> -shift;
+}
+
+void TextureStreaming::readFeedback()
+{
+    m_feedbackReadback.read([this](const GLuint* feedback, uint64_t frame)
+    {
+        std::vector<int> wanted(m_textures.size(), std::numeric_limits<int>::max());
+        for (size_t material = 0; material < m_materialTextures.size(); ++material)
+        {
+            // 0 is written for one texel per pixel at 1x1, so it also means "not seen"
+            if (feedback[material] == 0u)
+                continue;
+            for (const size_t texture : m_materialTextures[material])
+            {
+                const StreamedTexture& entry = m_textures[texture];
+                const int largest = static_cast<int>(std::floor(std::log2(std::max(entry.size.x, entry.size.y))));
+                wanted[texture] = std::min(wanted[texture], largest - static_cast<int>(feedback[material]));
+            }
+        }
+
+        for (size_t texture = 0; texture < m_textures.size(); ++texture)
+        {
+            StreamedTexture& entry = m_textures[texture];
+            const int minLevel = getMinLevel(entry);
+            if (wanted[texture] != std::numeric_limits<int>::max())
+            {
+                // finer levels are taken at once, coarser ones only after the finer ones expired
+                const int level = std::clamp(wanted[texture], 0, minLevel);
+                if (level <= entry.requestedLevel || frame > entry.lastRequest + keepFrames)
+                {
+                    entry.requestedLevel = level;
+                    entry.lastRequest = frame;
+                }
+            }
+            else if (frame > entry.lastRequest + keepFrames)
+            {
+                entry.requestedLevel = minLevel;
+            }
+        }
+    });
+}
+
+size_t TextureStreaming::stream(StreamedTexture& entry, int baseLevel)
+{
+    entry.uploading = true;
+
+    if (baseLevel > entry.baseLevel)
+    {
+        // all coarser levels are in video memory already
+        auto result = std::make_shared<Texture>(entry.texture->copyLevels(baseLevel - entry.baseLevel));
+        m_finished->push_back({ entry.texture, baseLevel, std::move(result) });
+    }
+    else if (m_uploadService)
+    {
+        m_uploadService->loadTextureLevels(entry.sourceFile, entry.channels, baseLevel,
+            [finished = m_finished, target = entry.texture, baseLevel](std::shared_ptr<Texture> result)
+            {
+                finished->push_back({ target, baseLevel, std::move(result) });
+            });
+    }
+    else
+    {
+        auto result = std::make_shared<Texture>(entry.sourceFile, entry.channels);
+        if (baseLevel > 0)
+            result = std::make_shared<Texture>(result->copyLevels(baseLevel));
+        m_finished->push_back({ entry.texture, baseLevel, std::move(result) });
+    }
+
+    return getLevelsSize(entry, baseLevel);
+}
+
+std::vector<std::pair<GLuint64, GLuint64>> TextureStreaming::update()
+{
+    ++m_frame;
+
+    std::unordered_map<const Texture*, size_t> lookup;
+    for (size_t i = 0; i < m_textures.size(); ++i)
+        lookup.emplace(m_textures[i].texture.get(), i);
+
+    // swap in the finished textures, the old handles die with the old storage
+    std::vector<std::pair<GLuint64, GLuint64>> replacedHandles;
+    for (auto& finished : *m_finished)
+    {
+        const GLuint64 oldHandle = finished.texture->handle();
+        const bool resident = finished.texture->isResident();
+        *finished.texture = std::move(*finished.replacement);
+
+        // residency is per context and might have been changed by TextureResidency
+        if (resident)
+            finished.texture->makeResident();
+        else
+            finished.texture->makeNonResident();
+        replacedHandles.emplace_back(oldHandle, finished.texture->handle());
+
+        const auto entry = lookup.find(finished.texture.get());
+        if (entry != lookup.end())
+        {
+            m_textures[entry->second].baseLevel = finished.baseLevel;
+            m_textures[entry->second].uploading = false;
+        }
+    }
+    m_finished->clear();
+
+    if (m_enabled && !m_materialTextures.empty())
+    {
+        readFeedback();
+
+        // the feedback is the finest resolution since the last request, keep accumulating if the readback is busy
+        if (m_feedbackReadback.request(m_feedbackBuffer, m_frame))
+        {
+            const GLuint zero = 0u;
+            glClearNamedBufferData(*m_feedbackBuffer.id(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+        }
+    }
+
+    // finest requests first, so the most visible textures are streamed in before the budget is spent
+    std::vector<size_t> order;
+    for (size_t i = 0; i < m_textures.size(); ++i)
+    {
+        const StreamedTexture& entry = m_textures[i];
+        if (!entry.uploading && entry.requestedLevel != entry.baseLevel)
+            order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(),
+        [this](size_t a, size_t b) { return m_textures[a].requestedLevel < m_textures[b].requestedLevel; });
+
+    size_t uploaded = 0;
+    for (const size_t i : order)
+    {
+        if (uploaded >= uploadBytesPerUpdate)
+            break;
+        uploaded += stream(m_textures[i], m_textures[i].requestedLevel);
+    }
+
+    return replacedHandles;
+}
+
+size_t TextureStreaming::getStreamedSize() const
+{
+    size_t size = 0;
+    for (const auto& entry : m_textures)
+        size += entry.texture->getMemorySize();
+    return size;
+}
+
+size_t TextureStreaming::getFullSize() const
+{
+    size_t size = 0;
+    for (const auto& entry : m_textures)
+        size += getLevelsSize(entry, 0);
+    return size;
+}
+
+bool TextureStreaming::drawGuiWindow()
+{
+    ImGui::SetNextWindowSize(ImVec2(300, 120), ImGuiSetCond_FirstUseEver);
+    ImGui::Begin("Texture Streaming");
+    const bool changed = drawGuiContent();
+    ImGui::End();
+    return changed;
+}
+
+bool TextureStreaming::drawGuiContent()
+{
+    ImGui::PushID(this);
+
+    bool enabled = m_enabled;
+    const bool changed = ImGui::Checkbox("Enabled", &enabled);
+    if (changed)
+        setEnabled(enabled);
+
+    const size_t uploading = std::count_if(m_textures.begin(), m_textures.end(),
+        [](const StreamedTexture& entry) { return entry.uploading; });
+    ImGui::Text("%zu textures, %zu uploading", m_textures.size(), uploading);
+    ImGui::Text("%.1f of %.1f MB in video memory", getStreamedSize() / (1024.0 * 1024.0), getFullSize() / (1024.0 * 1024.0));
+
+    ImGui::PopID();
+    return changed;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <glbinding/gl/gl.h>
+#include "Buffer.hpp"
+#include "ReadbackBuffer.hpp"
+#include "Texture.hpp"
+
+using namespace gl;
+
+class UploadService;
+
+/**
+ * @brief Streams the fine mipmap levels of the material textures depending on the resolution they are seen with.
+ * @details getMaterial (material.glsl) writes the log2 of the texture resolution that is needed to map one texel to
+ * one pixel into a feedback buffer, once per material since all textures of a material share the uv coordinates.
+ * TextureStreaming::update reads the feedback back without waiting for the GPU and reallocates every texture with the
+ * finest level it needs, the coarse levels up to TextureStreaming::minResolution are always kept. Textures are reduced
+ * to these levels as soon as they are passed to TextureStreaming::setMaterials. Levels that were not requested for
+ * TextureStreaming::keepFrames frames are dropped again. Since bindless texture state is immutable after the handle was
+ * created, a texture is reallocated with fewer levels instead of clamping its base level. Dropping levels copies the
+ * remaining ones on the GPU, finer levels are decoded from the source file of the texture (see Texture::getSourceFile)
+ * on the UploadService thread if one is set. Nothing is kept in system memory. Textures without a source file, e.g.
+ * ones that were modified after loading, are not streamed. The feedback is only written while streaming is enabled.
+ */
+class TextureStreaming
+{
+public:
+    TextureStreaming();
+
+    TextureStreaming(const TextureStreaming& other) = delete;
+    TextureStreaming& operator=(const TextureStreaming& other) = delete;
+
+    /** @brief The largest resolution that always stays in video memory. */
+    static constexpr int minResolution = 128;
+
+    /** @brief The number of frames a level stays in video memory after it was requested the last time. */
+    static constexpr uint64_t keepFrames = 120;
+
+    /** @brief The number of bytes that are reallocated per update at most, to spread the uploads over several frames. */
+    static constexpr size_t uploadBytesPerUpdate = 32 * 1024 * 1024;
+
+    /**
+     * @brief Sets the textures that are referenced by each material, see TextureResidency::setMaterials.
+     * Textures that are not referenced anymore get all their levels back.
+     * @param materialTextures The textures of material i at index i, in the order of the material buffer.
+     */
+    void setMaterials(const std::vector<std::vector<std::shared_ptr<Texture>>>& materialTextures);
+
+    /** @brief Sets the service the levels are uploaded with, nullptr uploads them on the calling thread. */
+    void setUploadService(UploadService* uploadService);
+
+    /** @brief Streaming is enabled by default. Enabling drops the fine levels, disabling streams all levels back. */
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    /** @brief Binds the feedback buffer and its enabled flag, has to stay bound while materials are sampled. */
+    void bind() const;
+
+    /**
+     * @brief Reads back the feedback of finished frames, starts the uploads and swaps in the finished textures.
+     * Call once per frame, after UploadService::update if an upload service is set.
+     * @return The handles that were replaced (old, new), all materials referencing them have to be updated.
+     */
+    std::vector<std::pair<GLuint64, GLuint64>> update();
+
+    /** @return The video memory of all streamed textures at their current resolution in bytes. */
+    size_t getStreamedSize() const;
+
+    /** @return The video memory all streamed textures would need with all their levels in bytes. */
+    size_t getFullSize() const;
+
+    /**
+    * @brief Draws a ImGui-window with the memory of the streamed textures.
+    * @return true if streaming was enabled or disabled.
+    */
+    bool drawGuiWindow();
+
+    /**
+    * @brief Draws the ImGui-content with the memory of the streamed textures.
+    * @return true if streaming was enabled or disabled.
+    */
+    bool drawGuiContent();
+
+private:
+    struct StreamedTexture
+    {
+        std::shared_ptr<Texture> texture;
+        std::vector<GLuint> materials;
+        std::filesystem::path sourceFile;
+        unsigned int channels = 0;
+        glm::ivec2 size{ 0 };           // of level 0
+        int levels = 0;
+        int baseLevel = 0;              // the finest level in video memory
+        int requestedLevel = 0;
+        uint64_t lastRequest = 0;
+        bool uploading = false;
+    };
+
+    struct FinishedUpload
+    {
+        std::shared_ptr<Texture> texture;   // the streamed texture, indices change with the materials
+        int baseLevel;
+        std::shared_ptr<Texture> replacement;
+    };
+
+    /** @return The coarsest level that is always kept. */
+    static int getMinLevel(const StreamedTexture& texture);
+
+    /** @return The estimated video memory of the texture with the levels from baseLevel on. */
+    static size_t getLevelsSize(const StreamedTexture& texture, int baseLevel);
+
+    /** @brief Reads the feedback of all finished readbacks and updates the requested levels. */
+    void readFeedback();
+
+    /**
+     * @brief Creates a texture holding the levels from baseLevel on. Coarser levels are copied from the current texture,
+     * finer ones are decoded from the source file. Returns the size of the new texture in bytes.
+     */
+    size_t stream(StreamedTexture& texture, int baseLevel);
+
+    std::vector<StreamedTexture> m_textures;
+    std::vector<std::vector<size_t>> m_materialTextures; // indices into m_textures
+
+    Buffer<GLuint> m_feedbackBuffer;
+    Buffer<glm::uvec4> m_feedbackParameterBuffer; // x is the enabled flag, padded to the std140 block size
+    ReadbackBuffer<GLuint> m_feedbackReadback;
+
+    UploadService* m_uploadService = nullptr;
+    std::shared_ptr<std::vector<FinishedUpload>> m_finished; // shared with the callbacks of pending uploads
+
+    uint64_t m_frame = 1;
+    bool m_enabled = true;
+};
@@ -34,6 +34,11 @@ void Timer::stop()
     util::getGlError(__LINE__, __FUNCTION__);
 }
 
+float Timer::getTime() const
+{
+    return m_ftimes.empty() ? 0.0f : m_ftimes.back();
+}
+
 void Timer::drawGuiWindow(GLFWwindow* window)
 {
     ImGui::SetNextWindowSize(ImVec2(300, 100), ImGuiSetCond_FirstUseEver);
@@ -22,6 +22,11 @@ public:
      */
     void stop();
 
+    /**
+     * @brief returns the GPU time of the last start/stop pair in milliseconds (0 if nothing was measured yet)
+     */
+    float getTime() const;
+
     /**
      * @brief draws an imgui window with the frametime and a graph
      * @param window 
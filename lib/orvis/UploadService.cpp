@@ -0,0 +1,222 @@
+#include "UploadService.hpp"
+#include "GlState.hpp"
+
+#include <cstring>
+#include <iostream>
+#include "Util.hpp"
+#include "stb/stb_image.h"
+
+UploadService::UploadService(GLFWwindow* window)
+{
+    // a hidden window is the only portable way to get a second context from GLFW, it inherits the context hints
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_context = glfwCreateWindow(1, 1, "Upload Context", nullptr, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+    if (!m_context)
+        throw std::runtime_error("Could not create the shared context for uploads.");
+
+    // the flip flag of stb_image is process-global and the worker must not write it while the main thread loads
+    // images. All loaders flip, so it is set here once before the worker starts and only read there.
+    stbi_set_flip_vertically_on_load(true);
+
+    m_thread = std::thread([this]() { run(); });
+}
+
+UploadService::~UploadService()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_queue.clear();
+    }
+    m_condition.notify_all();
+    m_thread.join();
+
+    for (const auto& job : m_finished)
+        glDeleteSync(job.fence);
+
+    glfwDestroyWindow(m_context);
+}
+
+void UploadService::enqueue(std::function<void()> upload, std::function<void()> onReady)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back({ std::move(upload), std::move(onReady), nullptr });
+    }
+    m_condition.notify_one();
+}
+
+void UploadService::loadTexture(const std::filesystem::path& filename, unsigned int channels,
+    std::function<void(std::shared_ptr<Texture>)> onReady)
+{
+    loadTextureLevels(filename, channels, 0, std::move(onReady));
+}
+
+void UploadService::loadTextureLevels(const std::filesystem::path& filename, unsigned int channels, int baseLevel,
+    std::function<void(std::shared_ptr<Texture>)> onReady)
+{
+    auto texture = std::make_shared<std::shared_ptr<Texture>>();
+    enqueue([this, texture, filename, channels, baseLevel]()
+    {
+        const auto [format, internalFormat] = Texture::getFileFormats(channels);
+        const bool isHdr = stbi_is_hdr(filename.string().c_str());
+
+        int width, height, numChannels;
+        void* image = isHdr
+            ? static_cast<void*>(stbi_loadf(filename.string().c_str(), &width, &height, &numChannels, channels))
+            : static_cast<void*>(stbi_load(filename.string().c_str(), &width, &height, &numChannels, channels));
+
+        if (!image)
+            throw std::runtime_error("Could not load texture " + filename.string());
+
+        const GLenum type = isHdr ? GL_FLOAT : GL_UNSIGNED_BYTE;
+        const size_t size = size_t(width) * height * channels * (isHdr ? sizeof(float) : sizeof(stbi_uc));
+
+        *texture = std::make_shared<Texture>(GL_TEXTURE_2D, internalFormat, glm::ivec2(width, height));
+
+        const GLintptr offset = stage(image, size);
+        if (offset >= 0)
+        {
+            GlState::get().bindBuffer(GL_PIXEL_UNPACK_BUFFER, *m_stagingBuffer.id());
+            (*texture)->assign2D(0, glm::ivec2(0), glm::ivec2(width, height), format, type, reinterpret_cast<const void*>(offset));
+            GlState::get().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        else
+        {
+            (*texture)->assign2D(format, type, image);
+        }
+        stbi_image_free(image);
+
+        (*texture)->generateMipmaps();
+        (*texture)->setSourceFile(filename, channels);
+        if (baseLevel > 0)
+            *texture = std::make_shared<Texture>((*texture)->copyLevels(baseLevel));
+
+        // residency is per context, the handle is made resident in the render context once the upload finished
+        (*texture)->makeNonResident();
+    },
+    [texture, onReady = std::move(onReady)]()
+    {
+        (*texture)->makeResident();
+        onReady(*texture);
+    });
+}
+
+int UploadService::update()
+{
+    int finished = 0;
+    while (true)
+    {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // jobs finish in order, so the first pending fence blocks all later ones
+            if (m_finished.empty() || glClientWaitSync(m_finished.front().fence, GL_NONE_BIT, 0) == GL_TIMEOUT_EXPIRED)
+                break;
+
+            job = std::move(m_finished.front());
+            m_finished.pop_front();
+        }
+
+        glDeleteSync(job.fence);
+        if (job.onReady)
+            job.onReady();
+        ++finished;
+    }
+    return finished;
+}
+
+size_t UploadService::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queue.size() + m_running + m_finished.size();
+}
+
+void UploadService::run()
+{
+    glfwMakeContextCurrent(m_context);
+    util::initGL();
+
+    const auto flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    m_stagingBuffer = Buffer<std::byte>(nullptr, stagingRegionSize * stagingRegionCount, flags);
+    m_stagingData = m_stagingBuffer.map(flags);
+
+    // rows of 1 and 3 channel images are not 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+            if (m_stop)
+                break;
+
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+            ++m_running;
+        }
+
+        try
+        {
+            job.upload();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Upload failed: " << e.what() << std::endl;
+            job.onReady = nullptr;
+        }
+
+        if (m_stagingUsed)
+            fenceStaging();
+
+        // the flush makes the fence visible to the render context
+        job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+        glFlush();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_running;
+        m_finished.push_back(std::move(job));
+    }
+
+    for (const GLsync fence : m_stagingFences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+    }
+    glFinish();
+    m_stagingBuffer = Buffer<std::byte>();
+    glfwMakeContextCurrent(nullptr);
+}
+
+GLintptr UploadService::stage(const void* data, size_t size)
+{
+    if (size > stagingRegionSize)
+        return -1;
+
+    // every staging call gets a fresh region, a region is only waited for if it is reused while the GPU still reads it
+    if (m_stagingUsed)
+        fenceStaging();
+    GLsync& fence = m_stagingFences[m_stagingRegion];
+    if (fence)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    const GLintptr offset = static_cast<GLintptr>(m_stagingRegion * stagingRegionSize);
+    std::memcpy(m_stagingData + offset, data, size);
+    m_stagingUsed = true;
+    return offset;
+}
+
+void UploadService::fenceStaging()
+{
+    m_stagingFences[m_stagingRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+    m_stagingRegion = (m_stagingRegion + 1) % stagingRegionCount;
+    m_stagingUsed = false;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glbinding/gl/gl.h>
+#include <GLFW/glfw3.h>
+#include "Buffer.hpp"
+#include "Texture.hpp"
+
+using namespace gl;
+
+/**
+ * @brief Uploads resources on a worker thread that owns a hidden GLFW context shared with the render context.
+ * @details Jobs run in the order they were enqueued. Pixel and buffer data is copied to a persistently mapped staging
+ * buffer and transferred from there, so the driver does not have to copy it again. The staging buffer is split into
+ * fenced regions that are used one after another, so the next job is decoded and copied while the previous transfers
+ * are still running. It only waits if all regions are still read by the GPU. After every job a fence is
+ * inserted; UploadService::update, called once per frame on the render thread, hands the finished resources over
+ * once their fence has signaled, so the render thread never waits for an upload.
+ */
+class UploadService
+{
+public:
+    /**
+     * @brief Creates the shared context and starts the worker thread. Has to be called on the main thread.
+     * @param window The window whose context the resources are shared with.
+     */
+    explicit UploadService(GLFWwindow* window);
+
+    /** @brief Finishes the current job, discards the queued ones and destroys the shared context. */
+    ~UploadService();
+
+    UploadService(const UploadService& other) = delete;
+    UploadService& operator=(const UploadService& other) = delete;
+
+    /**
+     * @brief Runs upload on the worker thread and onReady on the render thread after the GPU executed the upload.
+     * @param upload Issues GL commands on the shared context. Must not touch objects the render thread modifies.
+     * Residency is per context, so bindless handles created here have to be made non-resident before it returns.
+     * @param onReady Called from UploadService::update.
+     */
+    void enqueue(std::function<void()> upload, std::function<void()> onReady = {});
+
+    /**
+     * @brief Decodes an image file on the worker thread, uploads it and generates its mipmaps.
+     * @param filename The path to the image file that is loaded.
+     * @param channels The number of channels that should be loaded (see Texture::getFileFormats).
+     * @param onReady Receives the finished texture on the render thread, its handle is already resident there.
+     */
+    void loadTexture(const std::filesystem::path& filename, unsigned int channels,
+        std::function<void(std::shared_ptr<Texture>)> onReady);
+
+    /**
+     * @brief Same as UploadService::loadTexture, but the finished texture only holds the levels from baseLevel on.
+     * The whole mipmap chain is generated on the worker and the coarse levels are copied, so they match the levels of
+     * a texture loaded with UploadService::loadTexture.
+     */
+    void loadTextureLevels(const std::filesystem::path& filename, unsigned int channels, int baseLevel,
+        std::function<void(std::shared_ptr<Texture>)> onReady);
+
+    /**
+     * @brief Creates a buffer from the given data on the worker thread.
+     * @param data The buffer contents, moved to the worker thread.
+     * @param flags Storage usage flags for glNamedBufferStorage.
+     * @param onReady Receives the finished buffer on the render thread.
+     */
+    template <typename T>
+    void uploadBuffer(std::vector<T> data, BufferStorageMask flags, std::function<void(std::shared_ptr<Buffer<T>>)> onReady);
+
+    /**
+     * @brief Hands all resources whose uploads have finished on the GPU over to the render thread. Call once per frame.
+     * @return The number of finished jobs.
+     */
+    int update();
+
+    /** @return The number of jobs that were enqueued but not handed over yet. */
+    size_t getPendingCount() const;
+
+    /** @brief The size of one staging region in bytes, larger uploads are passed to the driver directly. */
+    static constexpr size_t stagingRegionSize = 16 * 1024 * 1024;
+
+    /** @brief The number of staging regions, the number of transfers that can be in flight at once. */
+    static constexpr int stagingRegionCount = 4;
+
+private:
+    struct Job
+    {
+        std::function<void()> upload;
+        std::function<void()> onReady;
+        GLsync fence = nullptr;
+    };
+
+    /** @brief The worker thread, owns the shared context while it runs. */
+    void run();
+
+    /**
+     * @brief Copies data to the next free staging region. Only called on the worker thread.
+     * @return The offset into the staging buffer, or -1 if the data does not fit into a region.
+     */
+    GLintptr stage(const void* data, size_t size);
+
+    /** @brief Fences the commands that read the current region and moves to the next one. Only called on the worker thread. */
+    void fenceStaging();
+
+    GLFWwindow* m_context = nullptr;
+    std::thread m_thread;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<Job> m_queue;        // waiting for the worker
+    std::deque<Job> m_finished;     // issued by the worker, waiting for their fences
+    size_t m_running = 0;
+    bool m_stop = false;
+
+    // worker thread only
+    Buffer<std::byte> m_stagingBuffer;
+    std::byte* m_stagingData = nullptr;
+    std::vector<GLsync> m_stagingFences = std::vector<GLsync>(stagingRegionCount, nullptr);
+    int m_stagingRegion = 0;
+    bool m_stagingUsed = false;
+};
+
+template <typename T>
+void UploadService::uploadBuffer(std::vector<T> data, BufferStorageMask flags, std::function<void(std::shared_ptr<Buffer<T>>)> onReady)
+{
+    auto buffer = std::make_shared<std::shared_ptr<Buffer<T>>>();
+    enqueue([this, buffer, data = std::move(data), flags]()
+    {
+        const size_t size = data.size() * sizeof(T);
+        const GLintptr offset = stage(data.data(), size);
+        if (offset < 0)
+        {
+            *buffer = std::make_shared<Buffer<T>>(data, flags);
+            return;
+        }
+
+        *buffer = std::make_shared<Buffer<T>>(nullptr, static_cast<GLsizeiptr>(data.size()), flags);
+        glCopyNamedBufferSubData(*m_stagingBuffer.id(), *(*buffer)->id(), offset, 0, size);
+    },
+    [buffer, onReady = std::move(onReady)]() { onReady(*buffer); });
+}
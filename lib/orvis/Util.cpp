@@ -1,4 +1,5 @@
 #include "Util.hpp"
+#include "GlState.hpp"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb/stb_image_write.h"
 
@@ -213,7 +214,7 @@ namespace util
 
     void saveFBOtoFile(const std::string& name, GLFWwindow* window)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GlState::get().bindFramebuffer(GL_FRAMEBUFFER, 0);
         int width;
         int height;
         glfwGetFramebufferSize(window, &width, &height);
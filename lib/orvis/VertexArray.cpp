@@ -1,4 +1,5 @@
 #include "VertexArray.hpp"
+#include "GlState.hpp"
 
 VertexArray::VertexArray() : m_id(glCreateVertexArrayRAII())
 {
@@ -36,7 +37,7 @@ void VertexArray::binding(std::variant<GLuint, VertexAttributeBinding> attribute
 }
 
 GLvertexArray VertexArray::id() const { return m_id; }
-void   VertexArray::bind() const { glBindVertexArray(*m_id); }
+void   VertexArray::bind() const { GlState::get().bindVertexArray(*m_id); }
 
 VertexArray::VertexArray(const VertexArray& other)
         : VertexArray()
@@ -0,0 +1,61 @@
+#include "VisibilityBuffer.hpp"
+#include <array>
+#include "GlState.hpp"
+
+VisibilityBuffer::VisibilityBuffer(glm::ivec2 size)
+    : m_visibilityFBO(size),
+      m_visibilityTexture(std::make_shared<Texture>(GL_TEXTURE_2D, GL_RG32UI, size, 1)),
+      m_colorTexture(std::make_shared<Texture>(GL_TEXTURE_2D, GL_RGBA16F, size, 1)),
+      m_compositor(std::make_shared<Shader>(GL_FRAGMENT_SHADER, ShaderFile::load("fragment/visibilityComposite.frag")))
+{
+    m_visibilityFBO.addColorAttachment(0, m_visibilityTexture);
+    m_visibilityFBO.updateDrawBuffers();
+
+    m_opaqueProgram.attachNew(GL_VERTEX_SHADER, ShaderFile::load("vertex/visibility.vert"));
+    m_opaqueProgram.attachNew(GL_FRAGMENT_SHADER, ShaderFile::load("fragment/visibility.frag"));
+
+    std::vector<glsp::definition> alphaTestDefines = binding::defaultShaderDefines;
+    alphaTestDefines.emplace_back("ALPHA_TEST");
+    m_alphaTestProgram.attach(std::make_shared<Shader>(GL_VERTEX_SHADER, ShaderFile::load("vertex/visibility.vert"), alphaTestDefines));
+    m_alphaTestProgram.attach(std::make_shared<Shader>(GL_FRAGMENT_SHADER, ShaderFile::load("fragment/visibility.frag"), alphaTestDefines));
+
+    m_resolveProgram.attachNew(GL_COMPUTE_SHADER, ShaderFile::load("compute/visibilityResolve.comp"));
+}
+
+void VisibilityBuffer::resize(glm::ivec2 size)
+{
+    m_visibilityFBO.resize(size);
+    m_colorTexture->resize(GL_TEXTURE_2D, GL_RGBA16F, size, 1);
+}
+
+void VisibilityBuffer::render(const Scene& scene)
+{
+    const glm::ivec2 size = m_visibilityFBO.getSize();
+    const GLuint target = GlState::get().getDrawFramebuffer();
+
+    // VISIBILITY
+    constexpr std::array<GLuint, 4> emptyVisibility = { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF };
+    constexpr float farDepth = 1.0f;
+    glClearNamedFramebufferuiv(*m_visibilityFBO.id(), GL_COLOR, 0, emptyVisibility.data());
+    glClearNamedFramebufferfv(*m_visibilityFBO.id(), GL_DEPTH, 0, &farDepth);
+
+    // blending would mix the packed ids
+    glDisable(GL_BLEND);
+    m_visibilityFBO.bind();
+    scene.renderDepth(m_opaqueProgram, m_alphaTestProgram);
+    GlState::get().bindFramebuffer(GL_FRAMEBUFFER, target);
+    glEnable(GL_BLEND);
+
+    // RESOLVE (camera, scene buffers and indirect draw buffer are still bound from the visibility pass)
+    scene.bindGeometryBuffers();
+    m_visibilityTexture->bindImage(ImageBinding::visibility, GL_READ_ONLY, GL_RG32UI);
+    m_colorTexture->bindImage(ImageBinding::screenColor, GL_WRITE_ONLY, GL_RGBA16F);
+    m_resolveProgram.use();
+    glDispatchCompute((size.x + 15) / 16, (size.y + 15) / 16, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    // COMPOSITE
+    m_colorTexture->bind(TextureBinding::screenColor);
+    m_compositor.setCamera(scene.getCamera());
+    m_compositor.render();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glbinding/gl/gl.h>
+#include "FrameBuffer.hpp"
+#include "Scene.hpp"
+#include "ScreenFiller.hpp"
+#include "Shader.hpp"
+#include "Texture.hpp"
+
+using namespace gl;
+
+/**
+ * @brief Alternative renderer that rasterizes only the draw and triangle index of every pixel and shades each pixel
+ * exactly once in a compute pass, independent of overdraw and triangle density.
+ * @details The attributes are reconstructed from the multi-draw index and vertex buffers of the scene.
+ * Transparent meshes are alpha-tested and rendered as cutouts, blending is not supported.
+ * The draw and triangle index are stored with 32 bits each (see visibility.glsl), so the draw count is not limited.
+ */
+class VisibilityBuffer
+{
+public:
+    /** @brief Creates the visibility and color targets with the given size (usually the window size). */
+    explicit VisibilityBuffer(glm::ivec2 size);
+
+    /** @brief Resizes all render targets. */
+    void resize(glm::ivec2 size);
+
+    /**
+     * @brief Culls and renders the scene with the camera of the scene and composites the shaded pixels
+     * onto the currently bound framebuffer (pixels without geometry keep their color, e.g. the skybox).
+     * The composited colors are linear, so the target should be a HdrRenderTarget.
+     */
+    void render(const Scene& scene);
+
+private:
+    FrameBuffer m_visibilityFBO;
+    std::shared_ptr<Texture> m_visibilityTexture;
+    std::shared_ptr<Texture> m_colorTexture;
+
+    Program m_opaqueProgram;
+    Program m_alphaTestProgram;
+    Program m_resolveProgram;
+    ScreenFiller m_compositor;
+};
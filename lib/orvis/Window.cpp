@@ -4,6 +4,7 @@
 #include "imgui/imgui_impl_opengl3.h"
 #include "imgui/imgui_impl_glfw.h"
 #include "Shader.hpp"
+#include "GlDeletionQueue.hpp"
 
 Window::Window(int width, int height, const std::string& title, const Hints& hints)
 {
@@ -54,6 +55,8 @@ Window::~Window() {
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
+    // objects released after this point are dropped with the context
+    GlDeletionQueue::get().finish();
     glfwDestroyWindow(m_window);
     glfwTerminate();
 }
@@ -85,6 +88,7 @@ float Window::update()
     if (glfwGetKey(m_window, GLFW_KEY_F5) == GLFW_PRESS)
         Program::reloadAll();
 
+    GlDeletionQueue::get().flush();
     glfwSwapBuffers(m_window);
     glfwPollEvents();
 
@@ -29,6 +29,7 @@ public:
      * @brief Polls GLFW events and swaps default framebuffers. If the window size is such that the
      * surface is invisible (i.e. one dimension is zero), update() blocks, still calling
      * glfwPollEvents(), until the window is resized back to a valid size.
+     * Also deletes the OpenGL objects the GPU is done with (see GlDeletionQueue::flush).
      * @return positive frametime if the window should be kept open, negative if there is a hint to close the window.
      */
     float update();
@@ -2,20 +2,30 @@
 #extension GL_ARB_bindless_texture : require
 layout(early_fragment_tests) in;
 
+// the shaded materials report the mip levels they need to TextureStreaming
+#define MIP_FEEDBACK
+
 layout(location = 0) in vec3 worldPos;
 layout(location = 1) in vec3 viewPos;
 layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 texCoord;
-layout(location = 4) flat in uint drawID;
+layout(location = 4) flat in uint materialIndex;
 
 #include "include/camera.glsl"
 #include "include/pbrShading.glsl"
 
+#ifdef MULTIVIEW
+layout(location = 5) flat in uint viewIndex;
+#define VIEW_POSITION views[viewIndex].position
+#else
+#define VIEW_POSITION camera.position
+#endif
+
 out vec4 fragColor;
 
 void main()
 {
-//	Material mat = getMaterial(drawID, texCoord);
+//	Material mat = getMaterial(materialIndex, texCoord);
 //
 //	fragColor.xyz = getAmbientLight() * mat.albedo.xyz;
 //
@@ -23,9 +33,9 @@ void main()
 //
 //	fragColor.xyz += getLightRadiance(l, worldPos) * dot(normal, getLightDirection(l, worldPos)) * mat.albedo.xyz;
 //
-	fragColor = getPBRColor(drawID, worldPos, normalize(normal), normalize(camera.position.xyz - worldPos), texCoord);
+	fragColor = getPBRColor(materialIndex, worldPos, normalize(normal), normalize(VIEW_POSITION - worldPos), texCoord);
 
-//	Material mat = getMaterial(drawID, texCoord);
+//	Material mat = getMaterial(materialIndex, texCoord);
 //	fragColor = vec4(vec3(mat.roughness), 1.0f);
 
 //	fragColor = vec4(0.5f * (normal + 1.0f), 1.0f);
@@ -2,13 +2,13 @@
 #extension GL_ARB_bindless_texture : require
 
 in vec2 passTexCoord;
-flat in uint passDrawID;
+flat in uint passMaterialIndex;
 
 #include "include/material.glsl"
 
 void main()
 {             
-    Material mat = getMaterial(passDrawID, passTexCoord);
+    Material mat = getMaterial(passMaterialIndex, passTexCoord);
 
 	if(mat.albedo.a < 0.9f)
 		discard;
@@ -8,11 +8,6 @@ layout(binding = SKYBOX_BINDING) uniform samplerCube cubeTexture;
 
 void main() 
 {
+	// linear radiance, tone mapping and gamma are applied once by the resolve (see HdrRenderTarget)
 	fragColor = texture(cubeTexture, rayDirection);
-
-	// tone mapping
-	fragColor.xyz = vec3(1.0f) - exp(-fragColor.xyz * camera.exposure);
-
-	// gamma
-    fragColor.xyz = pow(fragColor.xyz, vec3(1.0f/camera.gamma));
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 460
+#ifdef ALPHA_TEST
+#extension GL_ARB_bindless_texture : require
+#else
+layout(early_fragment_tests) in;
+#endif
+
+#include "include/visibility.glsl"
+
+#ifdef ALPHA_TEST
+#include "include/material.glsl"
+
+layout(location = 0) in vec2 texCoord;
+layout(location = 2) flat in uint materialIndex;
+#endif
+layout(location = 1) flat in uint drawID;
+
+layout(location = 0) out uvec2 visibility;
+
+void main()
+{
+#ifdef ALPHA_TEST
+    // blending is not possible here, transparent meshes become cutouts
+    if(getMaterial(materialIndex, texCoord).albedo.a < 0.5f)
+        discard;
+#endif
+
+    // gl_PrimitiveID restarts for every draw of the multi-draw
+    visibility = packVisibility(drawID, uint(gl_PrimitiveID));
+}
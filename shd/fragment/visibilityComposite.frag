@@ -0,0 +1,10 @@
+#version 430
+
+layout(location = 0) out vec4 fragColor;
+layout(binding = SCREEN_COLOR_BINDING) uniform sampler2D screenColor;
+
+void main() 
+{
+    // alpha is 0 where no geometry was rasterized, so the background is kept by blending
+	fragColor = texelFetch(screenColor, ivec2(gl_FragCoord.xy), 0);
+}
@@ -15,3 +15,9 @@ layout(std140, binding = CAMERA_BINDING) uniform CameraBuffer
 {
     CameraData camera;
 };
+
+// all views of a multi-view pass, view i is rendered to layer i (see Scene::setViews)
+layout(std430, binding = VIEWS_BINDING) readonly buffer ViewBuffer
+{
+    CameraData views[];
+};
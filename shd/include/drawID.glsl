@@ -0,0 +1,40 @@
+#pragma once
+
+// The culling pass stores the index of each draw in the base instance of its indirect command, so that any subrange of
+// the indirect buffer can be drawn (gl_DrawID restarts at 0 for every multi-draw call).
+// The lower bits are reserved for the mask of visible layers of layered passes, i.e. the cube faces of point light
+// shadow maps or the views of multi-view passes.
+const uint cubeFaceMaskBits = 6u;
+
+// layout of IndirectDrawCommand
+struct Indirect
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    uint baseVertex;
+    uint baseInstance;
+};
+
+uint encodeBaseInstance(in uint drawID, in uint faceMask)
+{
+    return (drawID << cubeFaceMaskBits) | faceMask;
+}
+
+uint getDrawID(in int baseInstance)
+{
+    return uint(baseInstance) >> cubeFaceMaskBits;
+}
+
+uint getCubeFaceMask(in int baseInstance)
+{
+    return uint(baseInstance) & ((1u << cubeFaceMaskBits) - 1u);
+}
+
+// layered draws issue one instance per set bit of the mask, instance n renders to the layer of the n-th set bit
+int getLayer(in uint layerMask, in int instanceID)
+{
+    for (int i = 0; i < instanceID; ++i)
+        layerMask &= layerMask - 1u;
+    return findLSB(layerMask);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// exponents for exponential variance shadow maps (limited by 32 bit float precision)
+#ifndef EVSM_POSITIVE_EXPONENT
+#define EVSM_POSITIVE_EXPONENT 40.0f
+#endif //EVSM_POSITIVE_EXPONENT
+
+#ifndef EVSM_NEGATIVE_EXPONENT
+#define EVSM_NEGATIVE_EXPONENT 5.0f
+#endif //EVSM_NEGATIVE_EXPONENT
+
+// warps a [0,1] depth value into its positive and negative exponential representation
+vec2 warpDepth(in float depth)
+{
+    depth = 2.0f * depth - 1.0f;
+    return vec2(exp(EVSM_POSITIVE_EXPONENT * depth), -exp(-EVSM_NEGATIVE_EXPONENT * depth));
+}
+
+// the four moments stored in a EVSM texel: (pos, pos^2, neg, neg^2)
+vec4 getEVSMMoments(in float depth)
+{
+    vec2 warped = warpDepth(depth);
+    return vec4(warped.x, warped.x * warped.x, warped.y, warped.y * warped.y);
+}
+
+// one-tailed chebyshev inequality, lightBleedingReduction cuts off the lower tail of the upper bound
+float chebyshevUpperBound(in vec2 moments, in float mean, in float minVariance, in float lightBleedingReduction)
+{
+    float variance = max(moments.y - moments.x * moments.x, minVariance);
+    float d = mean - moments.x;
+    float pMax = variance / (variance + d * d);
+    pMax = clamp((pMax - lightBleedingReduction) / (1.0f - lightBleedingReduction), 0.0f, 1.0f);
+    return mean <= moments.x ? 1.0f : pMax;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "material.glsl"
+
+// precomputed from the skybox by Cubemap::generateImageBasedLighting
+layout(binding = IRRADIANCE_BINDING) uniform samplerCube irradianceMap;
+layout(binding = SPECULAR_ENVIRONMENT_BINDING) uniform samplerCube specularEnvironmentMap;
+layout(binding = BRDF_LUT_BINDING) uniform sampler2D brdfLut;
+
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
+{
+    return F0 + (max(vec3(1.0f - roughness), F0) - F0) * pow(1.0f - cosTheta, 5.0f);
+}
+
+// diffuse and specular environment lighting with the split-sum approximation
+vec3 getImageBasedLighting(in Material mat, in vec3 normal, in vec3 viewDir, in vec3 F0)
+{
+    float NdotV = max(dot(normal, viewDir), 0.0f);
+    vec3 F = fresnelSchlickRoughness(NdotV, F0, mat.roughness);
+    vec3 kD = (vec3(1.0f) - F) * (1.0f - mat.metallic);
+
+    vec3 diffuse = texture(irradianceMap, normal).rgb * mat.albedo.rgb;
+
+    float maxLod = float(textureQueryLevels(specularEnvironmentMap) - 1);
+    vec3 prefiltered = textureLod(specularEnvironmentMap, reflect(-viewDir, normal), mat.roughness * maxLod).rgb;
+    vec2 brdf = texture(brdfLut, vec2(NdotV, mat.roughness)).rg;
+
+    return kD * diffuse + prefiltered * (F * brdf.x + brdf.y);
+}
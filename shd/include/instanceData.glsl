@@ -0,0 +1,31 @@
+#pragma once
+
+// per-draw data written by Scene::updateModelMatrices, indexed by the draw index (see drawID.glsl)
+struct InstanceData
+{
+    mat3x4 modelMatrix;         // rows of the affine model matrix, transform with vec4(position, 1) * modelMatrix
+    mat3 normalMatrix;          // transpose(inverse(modelMatrix))
+    mat3x4 previousModelMatrix; // model matrix of the previous update (for motion vectors), same layout as modelMatrix
+    uint materialIndex;         // index into the deduplicated material buffer
+    uint alphaTested;           // 1 for transparent meshes, which depth passes draw with the alpha test
+};
+
+layout(std430, binding = INSTANCE_DATA_BINDING) readonly buffer InstanceDataBuffer
+{
+    InstanceData instances[];
+};
+
+vec3 getWorldPosition(in InstanceData instance, in vec3 position)
+{
+    return vec4(position, 1.0f) * instance.modelMatrix;
+}
+
+vec3 getPreviousWorldPosition(in InstanceData instance, in vec3 position)
+{
+    return vec4(position, 1.0f) * instance.previousModelMatrix;
+}
+
+mat4 getModelMatrix(in InstanceData instance)
+{
+    return mat4(transpose(instance.modelMatrix));
+}
@@ -14,6 +14,13 @@ struct Light
 	uvec2 shadowMap; // can be sampler2DShadow or samplerCubeShadow
 
 	float pad1, pad2; //padding (not used)
+
+	uvec2 momentMap; // sampler2D containing prefiltered EVSM moments (not available for point lights)
+	int shadowFilter; // 0 PCF, 1 EVSM
+	float lightBleedingReduction; // EVSM
+
+	uvec2 minMaxMap; // sampler2D containing the min/max depth pyramid of the shadow map (not available for point lights)
+	float pad3, pad4; //padding (not used)
 };
 
 layout(std430, binding = LIGHTS_BINDING) readonly buffer LightBuffer
@@ -21,13 +28,21 @@ layout(std430, binding = LIGHTS_BINDING) readonly buffer LightBuffer
     Light lights[];
 };
 
-#ifndef AMBIENT_LIGHT
-#define AMBIENT_LIGHT vec3(0.01f);
-#endif //AMBIENT_LIGHT
+const vec3 cubeFaceForward[6] = vec3[6](vec3(1.0f, 0.0f, 0.0f), vec3(-1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f),
+                                         vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 0.0f, -1.0f));
+const vec3 cubeFaceUp[6] = vec3[6](vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f),
+                                    vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, -1.0f, 0.0f));
 
-vec3 getAmbientLight()
+// view matrix of the given cube map face (GL_TEXTURE_CUBE_MAP_POSITIVE_X + face) as seen from eye
+mat4 getCubeFaceViewMatrix(in int face, in vec3 eye)
 {
-	return AMBIENT_LIGHT;
+    vec3 f = cubeFaceForward[face];
+    vec3 s = normalize(cross(f, cubeFaceUp[face]));
+    vec3 u = cross(s, f);
+    return mat4(vec4(s.x, u.x, -f.x, 0.0f),
+                vec4(s.y, u.y, -f.y, 0.0f),
+                vec4(s.z, u.z, -f.z, 0.0f),
+                vec4(-dot(s, eye), -dot(u, eye), dot(f, eye), 1.0f));
 }
 
 vec3 getLightDirection(in Light l, in vec3 worldPos)
@@ -19,6 +19,32 @@ layout(std430, binding = MATERIALS_BINDING) readonly buffer MaterialBuffer
     RawMaterialData materials[];
 };
 
+// see TextureResidency, the textures of a material are only sampled while all of them are resident. Until then the
+// material is shaded with the placeholder values below, so draws never disappear while their textures are requested.
+layout(std430, binding = MATERIAL_RESIDENCY_BINDING) readonly buffer MaterialResidencyBuffer
+{
+    uint materialResident[];
+};
+
+const vec4 placeholderAlbedo = vec4(0.5f, 0.5f, 0.5f, 1.0f);
+const float placeholderRoughness = 0.5f;
+const float placeholderMetallic = 0.0f;
+
+// MIP_FEEDBACK is only defined by the shading passes. The depth and shadow passes leave it out, since the buffer
+// write would disable early depth tests in their alpha tested variants.
+#ifdef MIP_FEEDBACK
+// log2 of the finest texture resolution each material was sampled with, read by TextureStreaming
+layout(std430, binding = MATERIAL_FEEDBACK_BINDING) buffer MaterialFeedbackBuffer
+{
+    uint materialFeedback[];
+};
+
+layout(std140, binding = MATERIAL_FEEDBACK_PARAMETERS_BINDING) uniform MaterialFeedbackParameters
+{
+    uint mipFeedbackEnabled; // set while TextureStreaming is enabled
+};
+#endif
+
 struct Material
 {
 	vec4 albedo; 
@@ -30,19 +56,66 @@ struct Material
 	float ao;	
 };
 
+// MATERIAL_FEATURES specializes the shader for one texture bitset (see MaterialProgram). The bitset then is a
+// constant, so the untaken branches and their fetches are removed and only the used members are read.
+#ifdef MATERIAL_FEATURES
+#define MATERIAL_TEXTURE_BIT(index) (bitfieldExtract(uint(MATERIAL_FEATURES), index, 1) == 1)
+#else
+#define MATERIAL_TEXTURE_BIT(index) (bitfieldExtract(materials[materialIndex].isTextureBitset, index, 1) == 1)
+#endif
+
+#ifdef MIP_FEEDBACK
+// at a resolution of 2^feedback one texel covers one pixel, the level the texture needs follows from its size
+void writeMipFeedback(in uint materialIndex, in vec2 dUVdx, in vec2 dUVdy)
+{
+    if (mipFeedbackEnabled == 0u || materials[materialIndex].isTextureBitset == 0u)
+        return;
+
+    float footprint = max(length(dUVdx), length(dUVdy));
+    uint feedback = uint(clamp(ceil(-log2(max(footprint, 1e-9f))), 0.0f, 31.0f));
+    // reading first skips the atomic for all but the first fragments of a material
+    if (materialFeedback[materialIndex] < feedback)
+        atomicMax(materialFeedback[materialIndex], feedback);
+}
+#endif
+
 Material getMaterial(in uint materialIndex, in vec2 uv)
 {
-    RawMaterialData rawMat = materials[materialIndex];
     Material mat;
+    bool resident = materialResident[materialIndex] != 0u;
+#if defined(MIP_FEEDBACK) && !defined(NO_DERIVATIVES)
+    writeMipFeedback(materialIndex, dFdx(uv), dFdy(uv));
+#endif
+
+	mat.albedo = MATERIAL_TEXTURE_BIT(0) ? (resident ? texture(sampler2D(materials[materialIndex].albedo), uv) : placeholderAlbedo) : vec4(unpackHalf2x16(materials[materialIndex].albedo.x), unpackHalf2x16(materials[materialIndex].albedo.y));
+	mat.roughness = MATERIAL_TEXTURE_BIT(1) ? (resident ? texture(sampler2D(materials[materialIndex].roughness), uv).x : placeholderRoughness) : uintBitsToFloat(materials[materialIndex].roughness.x);
+	mat.metallic = MATERIAL_TEXTURE_BIT(2) ? (resident ? texture(sampler2D(materials[materialIndex].metallic), uv).x : placeholderMetallic) : uintBitsToFloat(materials[materialIndex].metallic.x);
+
+	mat.normal = MATERIAL_TEXTURE_BIT(3) && resident ? texture(sampler2D(materials[materialIndex].normal), uv) : vec4(-1.0f);	
+	mat.ao = MATERIAL_TEXTURE_BIT(4) && resident ? texture(sampler2D(materials[materialIndex].ao), uv).x : 1.0f;
+	
+	mat.ior = materials[materialIndex].ior;
+
+	return mat;
+}
+
+// same as getMaterial, but with explicit uv derivatives for stages without implicit ones (e.g. compute)
+Material getMaterialGrad(in uint materialIndex, in vec2 uv, in vec2 dUVdx, in vec2 dUVdy)
+{
+    Material mat;
+    bool resident = materialResident[materialIndex] != 0u;
+#ifdef MIP_FEEDBACK
+    writeMipFeedback(materialIndex, dUVdx, dUVdy);
+#endif
 
-	mat.albedo = bitfieldExtract(rawMat.isTextureBitset, 0, 1) == 1 ? texture(sampler2D(rawMat.albedo), uv) : vec4(unpackHalf2x16(rawMat.albedo.x), unpackHalf2x16(rawMat.albedo.y));
-	mat.roughness = bitfieldExtract(rawMat.isTextureBitset, 1, 1) == 1 ? texture(sampler2D(rawMat.roughness), uv).x : uintBitsToFloat(rawMat.roughness.x);
-	mat.metallic = bitfieldExtract(rawMat.isTextureBitset, 2, 1) == 1 ? texture(sampler2D(rawMat.metallic), uv).x : uintBitsToFloat(rawMat.metallic.x);
+	mat.albedo = MATERIAL_TEXTURE_BIT(0) ? (resident ? textureGrad(sampler2D(materials[materialIndex].albedo), uv, dUVdx, dUVdy) : placeholderAlbedo) : vec4(unpackHalf2x16(materials[materialIndex].albedo.x), unpackHalf2x16(materials[materialIndex].albedo.y));
+	mat.roughness = MATERIAL_TEXTURE_BIT(1) ? (resident ? textureGrad(sampler2D(materials[materialIndex].roughness), uv, dUVdx, dUVdy).x : placeholderRoughness) : uintBitsToFloat(materials[materialIndex].roughness.x);
+	mat.metallic = MATERIAL_TEXTURE_BIT(2) ? (resident ? textureGrad(sampler2D(materials[materialIndex].metallic), uv, dUVdx, dUVdy).x : placeholderMetallic) : uintBitsToFloat(materials[materialIndex].metallic.x);
 
-	mat.normal = bitfieldExtract(rawMat.isTextureBitset, 3, 1) == 1 ? texture(sampler2D(rawMat.normal), uv) : vec4(-1.0f);	
-	mat.ao = bitfieldExtract(rawMat.isTextureBitset, 4, 1) == 1 ? texture(sampler2D(rawMat.ao), uv).x : 1.0f;
+	mat.normal = MATERIAL_TEXTURE_BIT(3) && resident ? textureGrad(sampler2D(materials[materialIndex].normal), uv, dUVdx, dUVdy) : vec4(-1.0f);	
+	mat.ao = MATERIAL_TEXTURE_BIT(4) && resident ? textureGrad(sampler2D(materials[materialIndex].ao), uv, dUVdx, dUVdy).x : 1.0f;
 	
-	mat.ior = rawMat.ior;
+	mat.ior = materials[materialIndex].ior;
 
 	return mat;
 }
@@ -3,6 +3,7 @@
 #include "light.glsl"
 #include "material.glsl"
 #include "shadowMapping.glsl"
+#include "imageBasedLighting.glsl"
 
 #ifndef PI
 #define PI 3.14159265359f
@@ -50,9 +51,8 @@ float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
     return ggx1 * ggx2;
 }
 
-vec4 getPBRColor(in uint materialIndex, in vec3 worldPos, in vec3 normal, in vec3 viewDir, in vec2 uv)
+vec4 getPBRColor(in Material mat, in vec3 worldPos, in vec3 normal, in vec3 viewDir)
 {
-	Material mat = getMaterial(materialIndex, uv);
 
     vec3 F0 = vec3(0.04f); 
     F0 = mix(F0, mat.albedo.xyz, mat.metallic);
@@ -82,17 +82,17 @@ vec4 getPBRColor(in uint materialIndex, in vec3 worldPos, in vec3 normal, in vec
             
         // add to outgoing radiance Lo
         float NdotL = max(dot(normal, L), 0.0f);                
-        Lo += (kD * mat.albedo.xyz / PI + specular) * getLightRadiance(l, worldPos) * NdotL * getShadowPCF(l, worldPos, normal, L); 
+        Lo += (kD * mat.albedo.xyz / PI + specular) * getLightRadiance(l, worldPos) * NdotL * getShadow(l, worldPos, normal, L); 
     }   
   
-    vec3 ambient = getAmbientLight() * mat.albedo.xyz * mat.ao;
+    vec3 ambient = getImageBasedLighting(mat, normal, viewDir, F0) * mat.ao;
     vec3 color = ambient + Lo;
-	
-	// tone mapping
-	color = vec3(1.0f) - exp(-color * camera.exposure);
-
-	// gamma
-    color = pow(color, vec3(1.0f/camera.gamma));
 
+	// linear radiance, tone mapping and gamma are applied once by the resolve (see HdrRenderTarget)
 	return vec4(color, mat.albedo.a);
 }
+
+vec4 getPBRColor(in uint materialIndex, in vec3 worldPos, in vec3 normal, in vec3 viewDir, in vec2 uv)
+{
+	return getPBRColor(getMaterial(materialIndex, uv), worldPos, normal, viewDir);
+}
@@ -0,0 +1,33 @@
+// PCF kernel specialized for the radius PCF_KERNEL_SIZE, instantiated once per radius inside getShadowPCF.
+// Expects sm (sampler2DShadow), texelPos (position in texels), texelSize and ref (reference depth) to be in scope.
+{
+    const int go = PCF_KERNEL_SIZE;
+
+    vec2 base = floor(texelPos);
+    vec2 f = texelPos - base;
+
+    //per texel weights: the gaussian convolved with the bilinear footprint of a single comparison tap
+    float weightsX[2 * go + 2];
+    float weightsY[2 * go + 2];
+    for (int i = 0; i < 2 * go + 2; ++i)
+    {
+        float previous = i > 0 ? pcfWeights[go][i - 1] : 0.0f;
+        weightsX[i] = mix(pcfWeights[go][i], previous, f.x);
+        weightsY[i] = mix(pcfWeights[go][i], previous, f.y);
+    }
+
+    //each gather at a texel corner returns the comparison results of a 2x2 block
+    float shadow = 0.0f;
+    for (int y = 0; y <= go; ++y)
+    {
+        for (int x = 0; x <= go; ++x)
+        {
+            vec4 s = textureGather(sm, (base - go + 2.0f * vec2(x, y) + 1.0f) * texelSize, ref);
+            shadow += s.w * weightsX[2 * x] * weightsY[2 * y] + s.z * weightsX[2 * x + 1] * weightsY[2 * y]
+                    + s.x * weightsX[2 * x] * weightsY[2 * y + 1] + s.y * weightsX[2 * x + 1] * weightsY[2 * y + 1];
+        }
+    }
+
+    return shadow;
+}
+#undef PCF_KERNEL_SIZE
@@ -0,0 +1,17 @@
+#pragma once
+
+// parameters of HdrRenderTarget::resolve, shared by all post processing passes
+layout(std140, binding = POST_PROCESSING_BINDING) uniform PostProcessingBuffer
+{
+    vec2 renderScale;       // fraction of the HDR target that holds the rendered image
+    float bloomIntensity;
+    float bloomThreshold;
+    float vignetteStrength;
+    float saturation;
+    float contrast;
+};
+
+float getLuma(in vec3 color)
+{
+    return dot(color, vec3(0.299f, 0.587f, 0.114f));
+}
@@ -1,11 +1,89 @@
 #pragma once
 
 #include "light.glsl"
+#include "evsm.glsl"
 
-// point light shadows do not work at the moment
-float getPointShadow(in Light l, in vec3 worldPos, in vec3 lightDir)
+// normalized 1D gaussian weights, row k contains the 2k+1 weights of the kernel with radius k
+const float pcfWeights[MAX_PCF_KERNEL_SIZE + 1][2 * MAX_PCF_KERNEL_SIZE + 2] = PCF_WEIGHTS;
+
+// projected depth of a position (relative to the light) in the cube face it falls into
+float getCubeShadowDepth(in Light l, in vec3 fromLight)
 {
-    return 1.0f;
+    // all faces share the same projection, only the distance along the major axis matters
+    float z = max(abs(fromLight.x), max(abs(fromLight.y), abs(fromLight.z)));
+    vec4 clipPos = l.lightSpaceMatrix * vec4(0.0f, 0.0f, -z, 1.0f);
+    return 0.5f * clipPos.z / clipPos.w + 0.5f;
+}
+
+float getPointShadow(in Light l, in vec3 worldPos, in vec3 worldNormal, in vec3 lightDir)
+{
+	//no shadow map available
+	if(l.shadowMap.x == 0 && l.shadowMap.y == 0)
+		return 1.0f;
+
+    vec3 fromLight = worldPos - l.position;
+
+    //calculate bias
+    float cos_phi = max(dot(normalize(worldNormal), normalize(lightDir)), 0.0f);
+    float bias = -0.00001f * tan(acos(cos_phi));
+
+    samplerCubeShadow sm = samplerCubeShadow(l.shadowMap);
+
+    //kernel offsets are placed on the plane orthogonal to the lookup direction, scaled to one texel of the hit face
+    float majorAxis = max(abs(fromLight.x), max(abs(fromLight.y), abs(fromLight.z)));
+    float texelSize = 2.0f * majorAxis / textureSize(sm, 0).x;
+    vec3 lookupDir = normalize(fromLight);
+    vec3 tangent = normalize(cross(lookupDir, abs(lookupDir.y) < 0.99f ? vec3(0.0f, 1.0f, 0.0f) : vec3(1.0f, 0.0f, 0.0f)));
+    vec3 bitangent = cross(lookupDir, tangent);
+
+    float shadow = 0.0f;
+
+    //precomputed gaussian weights, already normalized
+    int go = clamp(l.pcfKernelSize, 0, MAX_PCF_KERNEL_SIZE);
+    for (int x = -go; x <= go; ++x)
+    {
+        for (int y = -go; y <= go; ++y)
+        {
+            vec3 sampleVec = fromLight + (x * tangent + y * bitangent) * texelSize;
+            float weight = pcfWeights[go][x + go] * pcfWeights[go][y + go];
+            shadow += weight * texture(sm, vec4(sampleVec, getCubeShadowDepth(l, sampleVec) - bias));
+        }
+    }
+
+    return shadow;
+}
+
+// 1 if the kernel footprint around projCoords ([0,1] light space) is fully lit, 0 if it is fully occluded, -1 if it has to be filtered
+float getShadowEarlyOut(in Light l, in vec3 projCoords, in int kernelRadius)
+{
+	//no pyramid available
+	if(l.minMaxMap.x == 0 && l.minMaxMap.y == 0)
+		return -1.0f;
+
+    sampler2D minMaxMap = sampler2D(l.minMaxMap);
+
+    //texels touched by the kernel including the bilinear footprint of the hardware comparison
+    ivec2 first = ivec2(floor(projCoords.xy * textureSize(minMaxMap, 0) - 0.5f)) - kernelRadius;
+    ivec2 last = first + 2 * kernelRadius + 1;
+
+    //coarsest level needed so that the footprint covers at most 2x2 texels
+    int level = min(int(ceil(log2(2.0f * kernelRadius + 2.0f))), textureQueryLevels(minMaxMap) - 1);
+    ivec2 levelSize = textureSize(minMaxMap, level);
+    first = clamp(first >> level, ivec2(0), levelSize - 1);
+    last = clamp(last >> level, ivec2(0), levelSize - 1);
+
+    vec2 a = texelFetch(minMaxMap, first, level).xy;
+    vec2 b = texelFetch(minMaxMap, ivec2(last.x, first.y), level).xy;
+    vec2 c = texelFetch(minMaxMap, ivec2(first.x, last.y), level).xy;
+    vec2 d = texelFetch(minMaxMap, last, level).xy;
+    float minDepth = min(min(a.x, b.x), min(c.x, d.x));
+    float maxDepth = max(max(a.y, b.y), max(c.y, d.y));
+
+    if(projCoords.z <= minDepth)
+        return 1.0f;
+    if(projCoords.z > maxDepth)
+        return 0.0f;
+    return -1.0f;
 }
 
 float getShadowPCF(in Light l, in vec3 worldPos, in vec3 worldNormal, in vec3 lightDir)
@@ -14,6 +92,10 @@ float getShadowPCF(in Light l, in vec3 worldPos, in vec3 worldNormal, in vec3 li
 	if(l.shadowMap.x == 0 && l.shadowMap.y == 0)
 		return 1.0f;
 
+    //point lights use cube shadow maps
+    if(l.type == 1)
+        return getPointShadow(l, worldPos, worldNormal, lightDir);
+
     //transform position to light space
     vec4 worldPosLightSpace = l.lightSpaceMatrix * vec4(worldPos, 1.0f);
     worldPosLightSpace = worldPosLightSpace * 0.5f + 0.5f * worldPosLightSpace.w; // transform to [0,w] range  
@@ -24,29 +106,84 @@ float getShadowPCF(in Light l, in vec3 worldPos, in vec3 worldNormal, in vec3 li
 
     worldPosLightSpace.z -= bias * worldPosLightSpace.w;
 
-    float shadow = 0.0f;
-
-    //gaussian stuff
-    float twoSigmaSq = max(1.0f, l.pcfKernelSize) * 2.0f;
-    float preFactor = 1.0f / (3.14159265f * twoSigmaSq);
-    float kernelSum = 0.0f;
+    //skip the kernel outside of penumbrae
+    float earlyOut = getShadowEarlyOut(l, worldPosLightSpace.xyz / worldPosLightSpace.w, l.pcfKernelSize);
+    if(earlyOut >= 0.0f)
+        return earlyOut;
 
     sampler2DShadow sm = sampler2DShadow(l.shadowMap);
     vec2 texelSize = 1.0f / textureSize(sm, 0);
-    int go = l.pcfKernelSize;
-    for (int x = -go; x <= go; ++x)
+    vec2 texelPos = worldPosLightSpace.xy / worldPosLightSpace.w / texelSize - 0.5f;
+    float ref = worldPosLightSpace.z / worldPosLightSpace.w;
+
+    //one specialized kernel per radius (up to MAX_PCF_KERNEL_SIZE), all fragments evaluate the same light so the switch is uniform
+    switch(clamp(l.pcfKernelSize, 0, MAX_PCF_KERNEL_SIZE))
     {
-        for (int y = -go; y <= go; ++y)
-        {
-            vec4 tcOffset = vec4(vec2(x, y) * texelSize * worldPosLightSpace.w, 0.f, 0.f);
-            float weight = preFactor * exp(-((x * x + y * y) / twoSigmaSq));
-            shadow += weight * textureProj(sm, worldPosLightSpace + tcOffset);
-            kernelSum += weight;
-        }
+    case 0:
+#define PCF_KERNEL_SIZE 0
+#include "pcfKernel.glsl"
+    case 1:
+#define PCF_KERNEL_SIZE 1
+#include "pcfKernel.glsl"
+    case 2:
+#define PCF_KERNEL_SIZE 2
+#include "pcfKernel.glsl"
+    case 3:
+#define PCF_KERNEL_SIZE 3
+#include "pcfKernel.glsl"
+    case 4:
+#define PCF_KERNEL_SIZE 4
+#include "pcfKernel.glsl"
+    case 5:
+#define PCF_KERNEL_SIZE 5
+#include "pcfKernel.glsl"
+    case 6:
+#define PCF_KERNEL_SIZE 6
+#include "pcfKernel.glsl"
+    case 7:
+#define PCF_KERNEL_SIZE 7
+#include "pcfKernel.glsl"
+    case 8:
+#define PCF_KERNEL_SIZE 8
+#include "pcfKernel.glsl"
+    case 9:
+#define PCF_KERNEL_SIZE 9
+#include "pcfKernel.glsl"
+    case 10:
+#define PCF_KERNEL_SIZE 10
+#include "pcfKernel.glsl"
     }
-    shadow /= kernelSum;
 
-    return shadow;
+    return 1.0f;
+}
+
+float getShadowEVSM(in Light l, in vec3 worldPos)
+{
+    //transform position to light space
+    vec4 worldPosLightSpace = l.lightSpaceMatrix * vec4(worldPos, 1.0f);
+    vec3 projCoords = worldPosLightSpace.xyz / worldPosLightSpace.w * 0.5f + 0.5f;
+
+    //the moment map is blurred and mipmapped, so a single filtered lookup replaces the PCF kernel
+    vec4 moments = texture(sampler2D(l.momentMap), projCoords.xy);
+    vec2 warpedDepth = warpDepth(projCoords.z);
+
+    //scale the minimum variance with the derivative of the warp to get a depth bias
+    vec2 depthScale = 0.0001f * vec2(EVSM_POSITIVE_EXPONENT, EVSM_NEGATIVE_EXPONENT) * warpedDepth;
+    vec2 minVariance = depthScale * depthScale;
+
+    float positiveShadow = chebyshevUpperBound(moments.xy, warpedDepth.x, minVariance.x, l.lightBleedingReduction);
+    float negativeShadow = chebyshevUpperBound(moments.zw, warpedDepth.y, minVariance.y, l.lightBleedingReduction);
+
+    return min(positiveShadow, negativeShadow);
+}
+
+float getShadow(in Light l, in vec3 worldPos, in vec3 worldNormal, in vec3 lightDir)
+{
+    //EVSM is only available if the light has a moment map, fall back to PCF otherwise
+    if(l.shadowFilter == 1 && (l.momentMap.x != 0 || l.momentMap.y != 0))
+        return getShadowEVSM(l, worldPos);
+
+    return getShadowPCF(l, worldPos, worldNormal, lightDir);
 }
 
 float getShadowBiased(in Light l, in vec3 worldPos, in vec3 worldNormal, in vec3 lightDir)
@@ -55,6 +192,14 @@ float getShadowBiased(in Light l, in vec3 worldPos, in vec3 worldNormal, in vec3
 	if(l.shadowMap.x == 0 && l.shadowMap.y == 0)
 		return 1.0f;
 
+    if(l.type == 1)
+    {
+        vec3 fromLight = worldPos - l.position;
+        float cos_phi = max(dot(normalize(worldNormal), normalize(lightDir)), 0.0f);
+        float bias = -0.00001f * tan(acos(cos_phi));
+        return texture(samplerCubeShadow(l.shadowMap), vec4(fromLight, getCubeShadowDepth(l, fromLight) - bias));
+    }
+
     //transform position to light space
     vec4 worldPosLightSpace = l.lightSpaceMatrix * vec4(worldPos, 1.0f);
     worldPosLightSpace = worldPosLightSpace * 0.5f + 0.5f * worldPosLightSpace.w; // transform to [0,w] range   
@@ -76,6 +221,12 @@ float calculateShadow(in Light l, in vec3 worldPos)
 	if(l.shadowMap.x == 0 && l.shadowMap.y == 0)
 		return 1.0f;
 
+    if(l.type == 1)
+    {
+        vec3 fromLight = worldPos - l.position;
+        return texture(samplerCubeShadow(l.shadowMap), vec4(fromLight, getCubeShadowDepth(l, fromLight)));
+    }
+
     //transform position to light space
     vec4 worldPosLightSpace = l.lightSpaceMatrix * vec4(worldPos, 1.0f);
     worldPosLightSpace = worldPosLightSpace * 0.5f + 0.5f * worldPosLightSpace.w; // transform to [0,w] range   
@@ -0,0 +1,20 @@
+#pragma once
+
+// a visibility texel stores the draw index (x) and the triangle index within the draw (y) with 32 bits each, so
+// scenes with many small draws (e.g. CAD models) are not limited by a packed encoding
+const uvec2 emptyVisibility = uvec2(0xFFFFFFFFu);
+
+uvec2 packVisibility(in uint drawID, in uint triangleID)
+{
+    return uvec2(drawID, triangleID);
+}
+
+uint getVisibilityDrawID(in uvec2 visibility)
+{
+    return visibility.x;
+}
+
+uint getVisibilityTriangleID(in uvec2 visibility)
+{
+    return visibility.y;
+}
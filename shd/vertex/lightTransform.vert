@@ -1,25 +1,43 @@
 #version 460
+#ifdef CUBE_SHADOW_MAP
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
 layout (location = VERTEX_LAYOUT) in vec4 vertexPosition;
+#ifndef DEPTH_ONLY
 layout (location = TEXCOORD_LAYOUT) in vec2 vertexTexCoord;
+#endif
 
 #include "include/light.glsl"
-
-layout (std430, binding = MODELMATRICES_BINDING) readonly buffer ModelMatrixBuffer
-{
-    mat4 modelMatrices[];
-};
+#include "include/drawID.glsl"
+#include "include/instanceData.glsl"
 
 layout (std140, binding = LIGHT_INDEX_BINDING) uniform LightIndexBuffer
 {
     int lightIndex;
 };
 
+#ifndef DEPTH_ONLY
 out vec2 passTexCoord;
-flat out uint passDrawID;
+flat out uint passMaterialIndex;
+#endif
 
 void main()
 {
-    gl_Position = lights[lightIndex].lightSpaceMatrix * modelMatrices[gl_DrawID] * vertexPosition;
-	passDrawID = gl_DrawID;
+    uint drawID = getDrawID(gl_BaseInstance);
+    vec4 worldPos = vec4(getWorldPosition(instances[drawID], vertexPosition.xyz), 1.0f);
+
+#ifdef CUBE_SHADOW_MAP
+    // the base instance holds the mask of visible cube faces
+    int face = getLayer(getCubeFaceMask(gl_BaseInstance), gl_InstanceID);
+
+    gl_Layer = face;
+    gl_Position = lights[lightIndex].lightSpaceMatrix * getCubeFaceViewMatrix(face, lights[lightIndex].position) * worldPos;
+#else
+    gl_Position = lights[lightIndex].lightSpaceMatrix * worldPos;
+#endif
+
+#ifndef DEPTH_ONLY
+	passMaterialIndex = instances[drawID].materialIndex;
 	passTexCoord = vertexTexCoord;
-}
\ No newline at end of file
+#endif
+}
@@ -1,33 +1,59 @@
 #version 460 
+#ifdef MULTIVIEW
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
 
 layout (location = VERTEX_LAYOUT) in vec4 vertexPosition;
+#ifndef DEPTH_ONLY
 layout (location = NORMAL_LAYOUT) in vec4 vertexNormal;
 layout (location = TEXCOORD_LAYOUT) in vec2 vertexTexCoord;
+#endif
 
 #include "include/camera.glsl"
+#include "include/drawID.glsl"
+#include "include/instanceData.glsl"
 
+// the depth prepass is compiled from this file as well, both have to produce bit-identical depths
+invariant gl_Position;
+
+#ifndef DEPTH_ONLY
 layout(location = 0) out vec3 worldPos;
 layout(location = 1) out vec3 viewPos;
 layout(location = 2) out vec3 normal;
 layout(location = 3) out vec2 texCoord;
-layout(location = 4) flat out uint drawID;
-
-layout (std430, binding = MODELMATRICES_BINDING) readonly buffer ModelMatrixBuffer
-{
-    mat4 modelMatrices[];
-};
+layout(location = 4) flat out uint materialIndex;
+#ifdef MULTIVIEW
+layout(location = 5) flat out uint viewIndex;
+#endif
+#endif
 
 void main()
 {
-    mat4 modelMatrix = modelMatrices[gl_DrawID];
-    drawID = gl_DrawID;
-
-    worldPos = (modelMatrix * vertexPosition).xyz;
-
-    viewPos = (camera.view * vec4(worldPos, 1.0f)).xyz;
-
-    gl_Position = camera.projection * vec4(viewPos, 1.0f);
-
-    normal = mat3(transpose(inverse(modelMatrix))) * vertexNormal.xyz;
+#ifdef DEPTH_ONLY
+    vec3 worldPos, viewPos;
+    uint viewIndex;
+#endif
+    uint drawID = getDrawID(gl_BaseInstance);
+    InstanceData instance = instances[drawID];
+
+#ifdef MULTIVIEW
+    // the base instance holds the mask of views that see this draw (see CullingMode::multiView)
+    viewIndex = uint(getLayer(getCubeFaceMask(gl_BaseInstance), gl_InstanceID));
+    gl_Layer = int(viewIndex);
+    CameraData viewCamera = views[viewIndex];
+#else
+    CameraData viewCamera = camera;
+#endif
+
+    worldPos = getWorldPosition(instance, vertexPosition.xyz);
+
+    viewPos = (viewCamera.view * vec4(worldPos, 1.0f)).xyz;
+
+    gl_Position = viewCamera.projection * vec4(viewPos, 1.0f);
+
+#ifndef DEPTH_ONLY
+    normal = instance.normalMatrix * vertexNormal.xyz;
     texCoord = vertexTexCoord;
-}
\ No newline at end of file
+    materialIndex = instance.materialIndex;
+#endif
+}
@@ -0,0 +1,28 @@
+#version 460
+
+layout (location = VERTEX_LAYOUT) in vec4 vertexPosition;
+#ifdef ALPHA_TEST
+layout (location = TEXCOORD_LAYOUT) in vec2 vertexTexCoord;
+#endif
+
+#include "include/camera.glsl"
+#include "include/drawID.glsl"
+#include "include/instanceData.glsl"
+
+#ifdef ALPHA_TEST
+layout(location = 0) out vec2 texCoord;
+layout(location = 2) flat out uint materialIndex;
+#endif
+layout(location = 1) flat out uint drawID;
+
+void main()
+{
+    drawID = getDrawID(gl_BaseInstance);
+
+    gl_Position = camera.projection * camera.view * vec4(getWorldPosition(instances[drawID], vertexPosition.xyz), 1.0f);
+
+#ifdef ALPHA_TEST
+    texCoord = vertexTexCoord;
+    materialIndex = instances[drawID].materialIndex;
+#endif
+}